@@ -0,0 +1,130 @@
+#include "src/memory.h"
+#include "src/stl_allocator.h"
+#include <benchmark/benchmark.h>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+const int iterations = 1000;
+
+using slab_memory = allocator::mmap_memory<4096>;
+
+template <typename T>
+using slab_allocator = allocator::stl_allocator<T, slab_memory>;
+
+using std_map = std::map<int, int>;
+using slab_map = std::map<int, int, std::less<int>, slab_allocator<std::pair<const int, int>>>;
+using std_unordered_map = std::unordered_map<int, int>;
+using slab_unordered_map = std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, slab_allocator<std::pair<const int, int>>>;
+using std_list = std::list<int>;
+using slab_list = std::list<int, slab_allocator<int>>;
+using std_deque = std::deque<int>;
+using slab_deque = std::deque<int, slab_allocator<int>>;
+
+template <typename _container_t>
+_container_t make_container(slab_memory& memory) {
+    if constexpr (std::is_default_constructible_v<typename _container_t::allocator_type>)
+        return _container_t{};
+    else
+        return _container_t{ typename _container_t::allocator_type{ memory } };
+}
+
+template <typename _container_t>
+void insert_element(_container_t& container, int key) {
+    if constexpr (requires { container.emplace(key, key); })
+        container.emplace(key, key);
+    else
+        container.push_back(key);
+}
+
+template <typename _container_t>
+void erase_element(_container_t& container, int key) {
+    if constexpr (requires { container.erase(key); })
+        container.erase(key);
+    else
+        container.pop_front();
+}
+
+template <typename _container_t>
+void insert(benchmark::State& state) {
+    auto memory = std::make_unique<slab_memory>();
+
+    for (auto _ : state) {
+        auto container = make_container<_container_t>(*memory);
+
+        for (int i = 0; i < iterations; ++i) {
+            insert_element(container, i);
+        }
+
+        benchmark::DoNotOptimize(container);
+    }
+}
+
+template <typename _container_t>
+void insert_and_erase(benchmark::State& state) {
+    auto memory = std::make_unique<slab_memory>();
+    auto container = make_container<_container_t>(*memory);
+
+    for (auto _ : state) {
+        for (int i = 0; i < iterations; ++i) {
+            insert_element(container, i);
+        }
+
+        for (int i = 0; i < iterations; ++i) {
+            erase_element(container, i);
+        }
+
+        benchmark::DoNotOptimize(container);
+    }
+}
+
+template <typename _container_t>
+void churn(benchmark::State& state) {
+    auto memory = std::make_unique<slab_memory>();
+    auto container = make_container<_container_t>(*memory);
+    int next_key = 0;
+
+    for (; next_key < 10 * iterations; ++next_key) {
+        insert_element(container, next_key);
+    }
+
+    for (auto _ : state) {
+        for (int i = 0; i < iterations; ++i, ++next_key) {
+            erase_element(container, next_key - 10 * iterations);
+            insert_element(container, next_key);
+        }
+
+        benchmark::DoNotOptimize(container);
+    }
+}
+
+BENCHMARK_TEMPLATE(insert, std_map);
+BENCHMARK_TEMPLATE(insert, slab_map);
+BENCHMARK_TEMPLATE(insert, std_unordered_map);
+BENCHMARK_TEMPLATE(insert, slab_unordered_map);
+BENCHMARK_TEMPLATE(insert, std_list);
+BENCHMARK_TEMPLATE(insert, slab_list);
+BENCHMARK_TEMPLATE(insert, std_deque);
+BENCHMARK_TEMPLATE(insert, slab_deque);
+
+BENCHMARK_TEMPLATE(insert_and_erase, std_map);
+BENCHMARK_TEMPLATE(insert_and_erase, slab_map);
+BENCHMARK_TEMPLATE(insert_and_erase, std_unordered_map);
+BENCHMARK_TEMPLATE(insert_and_erase, slab_unordered_map);
+BENCHMARK_TEMPLATE(insert_and_erase, std_list);
+BENCHMARK_TEMPLATE(insert_and_erase, slab_list);
+BENCHMARK_TEMPLATE(insert_and_erase, std_deque);
+BENCHMARK_TEMPLATE(insert_and_erase, slab_deque);
+
+BENCHMARK_TEMPLATE(churn, std_map);
+BENCHMARK_TEMPLATE(churn, slab_map);
+BENCHMARK_TEMPLATE(churn, std_unordered_map);
+BENCHMARK_TEMPLATE(churn, slab_unordered_map);
+BENCHMARK_TEMPLATE(churn, std_list);
+BENCHMARK_TEMPLATE(churn, slab_list);
+BENCHMARK_TEMPLATE(churn, std_deque);
+BENCHMARK_TEMPLATE(churn, slab_deque);
+
+BENCHMARK_MAIN();
\ No newline at end of file
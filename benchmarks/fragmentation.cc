@@ -0,0 +1,161 @@
+#include "src/free_memory_manager.h"
+#include "src/utils.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+const std::size_t slab_size = 1024;
+const std::size_t slab_count = 16 * 1024;
+const std::size_t operations = 100 * 1024;
+
+// Long-running churn of large (multi-slab) allocations with random sizes and lifetimes, keeping the pool
+// about 70% full. Reports how fragmented the empty space ends up being under each placement policy,
+// and how many allocations failed even though the pool was below its target occupancy.
+template <allocator::placement_policy _placement>
+void fragmentation(benchmark::State& state) {
+    using manager_t = allocator::free_memory_manager<slab_size, { .placement = _placement }>;
+    using slab_t = typename manager_t::slab_t;
+
+    std::vector<slab_t> slabs(slab_count);
+    allocator::launder_slab(slabs.data(), slabs.size());
+
+    manager_t manager;
+    manager.add_new_memory_segment(slabs.data());
+
+    std::mt19937 random{ 42 };
+    std::uniform_int_distribution<std::size_t> size_distribution{ 1, 24 * slab_size };
+    std::vector<std::pair<void*, std::size_t>> live;
+    std::size_t live_bytes = 0;
+    std::size_t failed_allocations = 0;
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < operations; ++i) {
+            if (live_bytes < slab_count * slab_size * 7 / 10) {
+                const auto size = size_distribution(random);
+                auto* const data = manager.allocate(size);
+
+                if (data != nullptr) {
+                    live.emplace_back(data, size);
+                    live_bytes += size;
+                    continue;
+                }
+
+                ++failed_allocations;
+            }
+
+            // Releases a random allocation when the pool is full enough (or too fragmented to serve the request).
+            const auto index = std::uniform_int_distribution<std::size_t>{ 0, live.size() - 1 }(random);
+
+            manager.deallocate(live[index].first);
+            live_bytes -= live[index].second;
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+
+    std::size_t free_bytes = 0;
+    std::size_t largest_free_run = 0;
+    std::size_t free_runs = 0;
+
+    for (auto* slab = &slabs[0]; slab != nullptr; slab = slab->header.neighbors.next) {
+        if (slab->is_empty()) {
+            free_bytes += slab->header.metadata.element_size;
+            largest_free_run = std::max(largest_free_run, slab->header.metadata.element_size);
+            ++free_runs;
+        }
+    }
+
+    state.counters["fragmentation"] = free_bytes ? 1.0 - static_cast<double>(largest_free_run) / free_bytes : 0.0;
+    state.counters["free_runs"] = static_cast<double>(free_runs);
+    state.counters["largest_free_run"] = static_cast<double>(largest_free_run);
+    state.counters["failed_allocations"] = benchmark::Counter(static_cast<double>(failed_allocations), benchmark::Counter::kAvgIterations);
+
+    for (const auto& [data, size] : live) {
+        manager.deallocate(data);
+    }
+}
+
+void fragmentation_with_first_fit(benchmark::State& state) {
+    fragmentation<allocator::placement_policy::first_fit>(state);
+}
+BENCHMARK(fragmentation_with_first_fit)->Iterations(20);
+
+void fragmentation_with_best_fit(benchmark::State& state) {
+    fragmentation<allocator::placement_policy::best_fit>(state);
+}
+BENCHMARK(fragmentation_with_best_fit)->Iterations(20);
+
+void fragmentation_with_address_ordered_fit(benchmark::State& state) {
+    fragmentation<allocator::placement_policy::address_ordered>(state);
+}
+BENCHMARK(fragmentation_with_address_ordered_fit)->Iterations(20);
+
+// Churn of small objects with random lifetimes. The pool is first filled up and then half of the objects are
+// released at random, leaving every slab about half used. Reports how many slabs still host the remaining objects
+// after a few rounds of churn (as opposed to having been drained and merged back into empty runs).
+template <std::size_t _occupancy_classes>
+void small_object_footprint(benchmark::State& state) {
+    using manager_t = allocator::free_memory_manager<slab_size, { .occupancy_classes = _occupancy_classes }>;
+    using slab_t = typename manager_t::slab_t;
+
+    std::vector<slab_t> slabs(slab_count);
+    allocator::launder_slab(slabs.data(), slabs.size());
+
+    manager_t manager;
+    manager.add_new_memory_segment(slabs.data());
+
+    std::mt19937 random{ 42 };
+    std::vector<void*> live;
+
+    for (std::size_t i = 0; i < 64 * 1024; ++i) {
+        live.push_back(manager.allocate(64));
+    }
+
+    std::shuffle(live.begin(), live.end(), random);
+
+    for (std::size_t i = 0; i < 32 * 1024; ++i) {
+        manager.deallocate(live.back());
+        live.pop_back();
+    }
+
+    for (auto _ : state) {
+        // Frees an eighth of the objects at random, then allocates them back.
+        for (std::size_t i = 0; i < operations / 16; ++i) {
+            const auto index = std::uniform_int_distribution<std::size_t>{ i, live.size() - 1 }(random);
+            std::swap(live[i], live[index]);
+            manager.deallocate(live[i]);
+        }
+
+        for (std::size_t i = 0; i < operations / 16; ++i) {
+            live[i] = manager.allocate(64);
+        }
+    }
+
+    std::size_t used_slabs = 0;
+
+    for (auto* slab = &slabs[0]; slab != nullptr; slab = slab->header.neighbors.next) {
+        if (!slab->is_empty()) {
+            ++used_slabs;
+        }
+    }
+
+    state.counters["used_slabs"] = static_cast<double>(used_slabs);
+    state.counters["min_slabs"] = static_cast<double>(live.size() / (slab_t::data_block_size / 64));
+
+    for (auto* data : live) {
+        manager.deallocate(data);
+    }
+}
+
+void small_object_footprint_with_single_list(benchmark::State& state) {
+    small_object_footprint<1>(state);
+}
+BENCHMARK(small_object_footprint_with_single_list)->Iterations(10);
+
+void small_object_footprint_with_occupancy_classes(benchmark::State& state) {
+    small_object_footprint<4>(state);
+}
+BENCHMARK(small_object_footprint_with_occupancy_classes)->Iterations(10);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,216 @@
+#include "src/memory.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+// Measures the latency of every single allocation and release (instead of the mean time of a loop) and reports
+// its percentiles, exposing the slow paths (splitting and merging runs, growing the memory) hidden by the mean.
+// Latencies include the overhead of reading the clock twice.
+
+// Log-linear histogram of latencies in nanoseconds: every power of two is divided into 16 buckets, so the reported
+// percentiles are within 1/16 of the measured latencies.
+class latency_histogram final {
+public:
+    void record(const std::uint64_t latency) {
+        ++_buckets[bucket_index(latency)];
+        ++_count;
+        _max = std::max(_max, latency);
+    }
+
+    // Upper bound of the bucket holding the given percentile.
+    std::uint64_t percentile(const double percentile) const {
+        const auto rank = static_cast<std::uint64_t>(percentile / 100 * (_count - 1)) + 1;
+        std::uint64_t count = 0;
+
+        for (std::size_t index = 0; index < _buckets.size(); ++index) {
+            count += _buckets[index];
+
+            if (count >= rank)
+                return std::min(bucket_upper_bound(index), _max);
+        }
+
+        return _max;
+    }
+
+    void report(benchmark::State& state) const {
+        state.counters["p50_ns"] = static_cast<double>(percentile(50));
+        state.counters["p99_ns"] = static_cast<double>(percentile(99));
+        state.counters["p99.9_ns"] = static_cast<double>(percentile(99.9));
+        state.counters["max_ns"] = static_cast<double>(_max);
+    }
+
+private:
+    static constexpr std::size_t _sub_buckets = 16;
+    static constexpr std::size_t _sub_bucket_bits = std::countr_zero(_sub_buckets);
+
+    static std::size_t bucket_index(const std::uint64_t latency) {
+        if (latency < _sub_buckets)
+            return latency;
+
+        const auto shift = std::bit_width(latency) - 1 - _sub_bucket_bits;
+        return (shift + 1) * _sub_buckets + ((latency >> shift) - _sub_buckets);
+    }
+
+    static std::uint64_t bucket_upper_bound(const std::size_t index) {
+        if (index < _sub_buckets)
+            return index;
+
+        const auto shift = index / _sub_buckets - 1;
+        return ((_sub_buckets + index % _sub_buckets + 1) << shift) - 1;
+    }
+
+    std::array<std::uint64_t, 64 * _sub_buckets> _buckets{};
+    std::uint64_t _count = 0;
+    std::uint64_t _max = 0;
+};
+
+template <typename _operation_t>
+auto measure(latency_histogram& histogram, _operation_t&& operation) {
+    const auto start = std::chrono::steady_clock::now();
+    auto result = operation();
+    const auto end = std::chrono::steady_clock::now();
+
+    benchmark::DoNotOptimize(result);
+    histogram.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+
+    return result;
+}
+
+struct malloc_memory final {
+    void* allocate(const std::size_t size) {
+        return std::malloc(size);
+    }
+
+    void deallocate(void* const data) {
+        std::free(data);
+    }
+};
+
+using pool_memory = allocator::mmap_memory<4096>;
+
+// Random interleaving of allocations and releases of mostly small objects (with some larger than a slab, which
+// split and merge empty runs), keeping about 16K of them alive.
+template <typename _memory_t>
+void interleaved_random_operations(benchmark::State& state) {
+    auto memory = std::make_unique<_memory_t>();
+    std::mt19937 random{ 42 };
+    std::geometric_distribution<std::size_t> size_distribution{ 0.01 };
+    std::vector<void*> live;
+    latency_histogram allocations;
+    latency_histogram deallocations;
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < 64 * 1024; ++i) {
+            if (live.size() < 16 * 1024 && (live.empty() || random() % 2)) {
+                const auto size = 16 + 16 * size_distribution(random);
+                live.push_back(measure(allocations, [&] { return memory->allocate(size); }));
+            }
+            else {
+                std::swap(live[random() % live.size()], live.back());
+                measure(deallocations, [&] { memory->deallocate(live.back()); return 0; });
+                live.pop_back();
+            }
+        }
+    }
+
+    for (auto* const data : live) {
+        memory->deallocate(data);
+    }
+
+    allocations.report(state);
+    state.counters["dealloc_p99.9_ns"] = static_cast<double>(deallocations.percentile(99.9));
+}
+
+void interleaved_random_operations_with_malloc(benchmark::State& state) {
+    interleaved_random_operations<malloc_memory>(state);
+}
+BENCHMARK(interleaved_random_operations_with_malloc);
+
+void interleaved_random_operations_with_memory(benchmark::State& state) {
+    interleaved_random_operations<pool_memory>(state);
+}
+BENCHMARK(interleaved_random_operations_with_memory);
+
+// Allocations from a fresh memory, every one of which either carves a new slab out of the current block or grows
+// the memory with a new block (reserving and first touching its pages).
+template <typename _memory_t>
+void first_touch_growth(benchmark::State& state) {
+    latency_histogram allocations;
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto memory = std::make_unique<_memory_t>();
+        std::vector<void*> pointers;
+        state.ResumeTiming();
+
+        for (std::size_t i = 0; i < 16 * 1024; ++i) {
+            pointers.push_back(measure(allocations, [&] { return memory->allocate(2000); }));
+        }
+
+        state.PauseTiming();
+        for (auto* const data : pointers) {
+            memory->deallocate(data);
+        }
+        state.ResumeTiming();
+    }
+
+    allocations.report(state);
+}
+
+void first_touch_growth_with_malloc(benchmark::State& state) {
+    first_touch_growth<malloc_memory>(state);
+}
+BENCHMARK(first_touch_growth_with_malloc)->Iterations(20);
+
+void first_touch_growth_with_memory(benchmark::State& state) {
+    first_touch_growth<pool_memory>(state);
+}
+BENCHMARK(first_touch_growth_with_memory)->Iterations(20);
+
+// Allocations and releases of large (multi-slab) objects of random sizes, which split and merge empty runs.
+template <typename _memory_t>
+void large_random_operations(benchmark::State& state) {
+    auto memory = std::make_unique<_memory_t>();
+    std::mt19937 random{ 42 };
+    std::uniform_int_distribution<std::size_t> size_distribution{ 4 * 1024, 256 * 1024 };
+    std::vector<void*> live;
+    latency_histogram allocations;
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < 16 * 1024; ++i) {
+            if (live.size() < 256 && (live.empty() || random() % 2)) {
+                const auto size = size_distribution(random);
+                live.push_back(measure(allocations, [&] { return memory->allocate(size); }));
+            }
+            else {
+                std::swap(live[random() % live.size()], live.back());
+                memory->deallocate(live.back());
+                live.pop_back();
+            }
+        }
+    }
+
+    for (auto* const data : live) {
+        memory->deallocate(data);
+    }
+
+    allocations.report(state);
+}
+
+void large_random_operations_with_malloc(benchmark::State& state) {
+    large_random_operations<malloc_memory>(state);
+}
+BENCHMARK(large_random_operations_with_malloc);
+
+void large_random_operations_with_memory(benchmark::State& state) {
+    large_random_operations<pool_memory>(state);
+}
+BENCHMARK(large_random_operations_with_memory);
+
+BENCHMARK_MAIN();
@@ -1,6 +1,21 @@
 #include "src/free_memory_manager.h"
+#include "src/memory.h"
+#include "src/memory_resource.h"
+#include "src/segment_pool.h"
+#include "src/tiered_memory.h"
+#include "src/typed_pool.h"
 #include "src/utils.h"
 #include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <vector>
 
 const std::size_t iterations = 1000;
 using mid_size_object = std::array<std::byte, 64>;
@@ -255,4 +270,488 @@ void big_allocations_with_free_memory_manager(benchmark::State& state) {
 }
 BENCHMARK(big_allocations_with_free_memory_manager);
 
+using small_node = std::array<std::byte, 16>;
+
+void same_size_node_allocations_with_free_memory_manager(benchmark::State& state) {
+    allocator::free_memory_manager<256> manager;
+    allocator::memory_slab<256> slabs[200];
+    allocator::launder_slab(slabs, 200);
+    manager.add_new_memory_segment(slabs);
+
+    for (auto _ : state) {
+        std::array<void*, iterations> pointers;
+
+        for (int i = 0; i < iterations; ++i) {
+            pointers[i] = manager.allocate(sizeof(small_node));
+            benchmark::DoNotOptimize(pointers[i]);
+        }
+
+        for (int i = 0; i < iterations; ++i) {
+            manager.deallocate(pointers[i]);
+        }
+    }
+}
+BENCHMARK(same_size_node_allocations_with_free_memory_manager);
+
+void same_size_node_allocations_with_free_memory_manager_batch(benchmark::State& state) {
+    allocator::free_memory_manager<256> manager;
+    allocator::memory_slab<256> slabs[200];
+    allocator::launder_slab(slabs, 200);
+    manager.add_new_memory_segment(slabs);
+
+    for (auto _ : state) {
+        std::array<void*, iterations> pointers;
+
+        manager.allocate_batch(sizeof(small_node), iterations, pointers.data());
+        benchmark::DoNotOptimize(pointers.data());
+
+        manager.deallocate_batch(pointers.data(), iterations);
+    }
+}
+BENCHMARK(same_size_node_allocations_with_free_memory_manager_batch);
+
+void same_size_node_allocations_with_typed_pool(benchmark::State& state) {
+    allocator::free_memory_manager<256> manager;
+    allocator::memory_slab<256> slabs[200];
+    allocator::launder_slab(slabs, 200);
+    manager.add_new_memory_segment(slabs);
+
+    allocator::typed_pool<small_node, allocator::free_memory_manager<256>> pool{ manager };
+
+    for (auto _ : state) {
+        std::array<void*, iterations> pointers;
+
+        for (int i = 0; i < iterations; ++i) {
+            pointers[i] = pool.allocate();
+            benchmark::DoNotOptimize(pointers[i]);
+        }
+
+        for (int i = 0; i < iterations; ++i) {
+            pool.deallocate(pointers[i]);
+        }
+    }
+}
+BENCHMARK(same_size_node_allocations_with_typed_pool);
+
+using odd_size_object = std::array<std::byte, 72>;
+
+template <allocator::free_memory_manager_options _options>
+void odd_size_allocations(benchmark::State& state) {
+    allocator::free_memory_manager<4096, _options> manager;
+    std::vector<typename allocator::free_memory_manager<4096, _options>::slab_t> slabs(100);
+    allocator::launder_slab(slabs.data(), slabs.size());
+    manager.add_new_memory_segment(slabs.data());
+
+    for (auto _ : state) {
+        std::array<void*, iterations> pointers;
+
+        for (int i = 0; i < iterations; ++i) {
+            pointers[i] = manager.allocate(sizeof(odd_size_object));
+        }
+
+        benchmark::DoNotOptimize(pointers.data());
+
+        for (int i = 0; i < iterations; ++i) {
+            manager.deallocate(pointers[i]);
+        }
+    }
+}
+
+void odd_size_allocations_with_power_of_two_size_classes(benchmark::State& state) {
+    odd_size_allocations<{}>(state);
+}
+BENCHMARK(odd_size_allocations_with_power_of_two_size_classes);
+
+void odd_size_allocations_with_four_size_classes_per_doubling(benchmark::State& state) {
+    odd_size_allocations<{ .size_classes_per_doubling = 4 }>(state);
+}
+BENCHMARK(odd_size_allocations_with_four_size_classes_per_doubling);
+
+void odd_size_allocations_with_statistics(benchmark::State& state) {
+    odd_size_allocations<{ .collect_statistics = true }>(state);
+}
+BENCHMARK(odd_size_allocations_with_statistics);
+
+// Reads the first object allocated in each of 1000 slabs (like the buckets of a hash table pointing to the first
+// of their nodes). Without colouring, all of them map to the same cache sets.
+template <allocator::free_memory_manager_options _options>
+void first_elements_of_slabs(benchmark::State& state) {
+    using manager_t = allocator::free_memory_manager<4096, _options>;
+
+    manager_t manager;
+    std::vector<typename manager_t::slab_t> slabs(1024);
+    allocator::launder_slab(slabs.data(), slabs.size());
+    manager.add_new_memory_segment(slabs.data());
+
+    const auto elements_per_slab = std::min(manager_t::slab_t::data_block_size / 16, 0 + manager_t::slab_t::max_bitmap_elements);
+    std::vector<std::uint64_t*> first_elements;
+
+    for (std::size_t i = 0; i < 1000 * elements_per_slab; ++i) {
+        auto* const data = static_cast<std::uint64_t*>(manager.allocate(16));
+        *data = i;
+
+        if (i % elements_per_slab == 0) {
+            first_elements.push_back(data);
+        }
+    }
+
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+
+        for (auto* const data : first_elements) {
+            sum += *data;
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+void first_elements_of_slabs_without_cache_colouring(benchmark::State& state) {
+    first_elements_of_slabs<{}>(state);
+}
+BENCHMARK(first_elements_of_slabs_without_cache_colouring);
+
+void first_elements_of_slabs_with_cache_colouring(benchmark::State& state) {
+    first_elements_of_slabs<{ .cache_colouring = true }>(state);
+}
+BENCHMARK(first_elements_of_slabs_with_cache_colouring);
+
+// Allocates, fills and releases small objects of a few sizes in small slabs. Also reports how many slabs (and
+// bytes, including the slab headers) the objects take when all of them are allocated.
+template <std::size_t _slab_size, allocator::free_memory_manager_options _options>
+void small_objects_in_small_slabs(benchmark::State& state) {
+    allocator::memory<allocator::mmap_block_allocator<>, _slab_size, 1, _options> memory;
+    std::array<void*, 4 * iterations> pointers;
+
+    const auto allocate_all = [&] {
+        for (std::size_t i = 0; i < pointers.size(); ++i) {
+            const auto size = std::size_t{ 16 } << (i % 3);
+            pointers[i] = memory.allocate(size);
+            std::memset(pointers[i], static_cast<int>(i), size);
+        }
+
+        benchmark::DoNotOptimize(pointers.data());
+    };
+
+    allocate_all();
+
+    std::size_t used_slabs = 0;
+    std::size_t used_bytes = 0;
+
+    memory.walk_heap([&](const allocator::heap_slab_info& info) {
+        if (info.state != allocator::slab_state::free_run) {
+            used_slabs += info.slabs;
+        }
+    });
+
+    if constexpr (_options.out_of_band_headers) {
+        used_bytes = used_slabs * (_slab_size + sizeof(typename decltype(memory)::slab_t));
+    }
+    else {
+        used_bytes = used_slabs * _slab_size;
+    }
+
+    for (auto* const data : pointers) {
+        memory.deallocate(data);
+    }
+
+    for (auto _ : state) {
+        allocate_all();
+
+        for (auto* const data : pointers) {
+            memory.deallocate(data);
+        }
+    }
+
+    state.counters["used_slabs"] = static_cast<double>(used_slabs);
+    state.counters["used_bytes"] = static_cast<double>(used_bytes);
+}
+
+void small_objects_in_small_slabs_with_in_band_headers(benchmark::State& state) {
+    small_objects_in_small_slabs<256, {}>(state);
+}
+BENCHMARK(small_objects_in_small_slabs_with_in_band_headers);
+
+void small_objects_in_small_slabs_with_compact_in_band_headers(benchmark::State& state) {
+    small_objects_in_small_slabs<256, { .compact_headers = true }>(state);
+}
+BENCHMARK(small_objects_in_small_slabs_with_compact_in_band_headers);
+
+void small_objects_in_small_slabs_with_out_of_band_headers(benchmark::State& state) {
+    small_objects_in_small_slabs<256, { .segment_size = 1024 * 1024, .out_of_band_headers = true }>(state);
+}
+BENCHMARK(small_objects_in_small_slabs_with_out_of_band_headers);
+
+void small_objects_in_small_slabs_with_compact_out_of_band_headers(benchmark::State& state) {
+    small_objects_in_small_slabs<256, { .segment_size = 1024 * 1024, .out_of_band_headers = true, .compact_headers = true }>(state);
+}
+BENCHMARK(small_objects_in_small_slabs_with_compact_out_of_band_headers);
+
+void small_objects_in_tiny_slabs_with_compact_in_band_headers(benchmark::State& state) {
+    small_objects_in_small_slabs<64, { .compact_headers = true }>(state);
+}
+BENCHMARK(small_objects_in_tiny_slabs_with_compact_in_band_headers);
+
+void small_objects_in_tiny_slabs_with_compact_out_of_band_headers(benchmark::State& state) {
+    small_objects_in_small_slabs<64, { .segment_size = 1024 * 1024, .out_of_band_headers = true, .compact_headers = true }>(state);
+}
+BENCHMARK(small_objects_in_tiny_slabs_with_compact_out_of_band_headers);
+
+void growing_buffer_with_realloc(benchmark::State& state) {
+    for (auto _ : state) {
+        void* buffer = std::malloc(1024);
+
+        for (std::size_t size = 2 * 1024; size <= 256 * 1024; size += 1024) {
+            buffer = std::realloc(buffer, size);
+            benchmark::DoNotOptimize(buffer);
+        }
+
+        std::free(buffer);
+    }
+}
+BENCHMARK(growing_buffer_with_realloc);
+
+void growing_buffer_with_memory_reallocate(benchmark::State& state) {
+    allocator::mmap_memory<1024> memory;
+
+    for (auto _ : state) {
+        void* buffer = memory.allocate(1024);
+
+        for (std::size_t size = 2 * 1024; size <= 256 * 1024; size += 1024) {
+            buffer = memory.reallocate(buffer, size);
+            benchmark::DoNotOptimize(buffer);
+        }
+
+        memory.deallocate(buffer);
+    }
+}
+BENCHMARK(growing_buffer_with_memory_reallocate);
+
+template <typename _memory_t>
+void random_order_frees(benchmark::State& state) {
+    const std::size_t count = 256 * 1024;
+    auto memory = std::make_unique<_memory_t>();
+    std::vector<mid_size_object*> pointers(count);
+    std::vector<std::size_t> order(count);
+
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), std::mt19937{ 42 });
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < count; ++i) {
+            pointers[i] = memory->template allocate<mid_size_object>();
+            benchmark::DoNotOptimize(pointers[i]);
+        }
+
+        for (const auto i : order) {
+            memory->deallocate(pointers[i]);
+        }
+    }
+}
+
+void random_order_frees_with_regular_pages(benchmark::State& state) {
+    random_order_frees<allocator::memory<allocator::mmap_block_allocator<1024 * 1024 * 1024, 2 * 1024 * 1024>, 1024, 64 * 1024 * 1024>>(state);
+}
+BENCHMARK(random_order_frees_with_regular_pages);
+
+void random_order_frees_with_transparent_huge_pages(benchmark::State& state) {
+    random_order_frees<allocator::memory<allocator::mmap_block_allocator<1024 * 1024 * 1024, 2 * 1024 * 1024, 2 * 1024 * 1024, true>, 1024, 64 * 1024 * 1024>>(state);
+}
+BENCHMARK(random_order_frees_with_transparent_huge_pages);
+
+void random_order_frees_with_explicit_huge_pages(benchmark::State& state) {
+    random_order_frees<allocator::memory<allocator::huge_page_block_allocator<1024 * 1024 * 1024>, 1024, 64 * 1024 * 1024>>(state);
+}
+BENCHMARK(random_order_frees_with_explicit_huge_pages);
+
+struct malloc_memory final {
+    void* allocate(const std::size_t size) {
+        return std::malloc(size);
+    }
+
+    void deallocate(void* const data) {
+        std::free(data);
+    }
+};
+
+// Allocates 1000 objects with sizes spread log-uniformly between 8 bytes and 64 KiB, and releases them in random order.
+template <typename _memory_t>
+void mixed_size_allocations(benchmark::State& state, _memory_t& memory) {
+    std::mt19937 random{ 42 };
+    std::vector<std::size_t> sizes(iterations);
+    std::vector<std::size_t> order(iterations);
+    std::vector<void*> pointers(iterations);
+
+    for (auto& size : sizes) {
+        size = std::size_t{ 8 } << random() % 13;
+        size += random() % size;
+    }
+
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), random);
+
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < iterations; ++i) {
+            pointers[i] = memory.allocate(sizes[i]);
+        }
+
+        benchmark::DoNotOptimize(pointers.data());
+
+        for (const auto i : order) {
+            memory.deallocate(pointers[i]);
+        }
+    }
+}
+
+void mixed_size_allocations_with_malloc(benchmark::State& state) {
+    malloc_memory memory;
+    mixed_size_allocations(state, memory);
+}
+BENCHMARK(mixed_size_allocations_with_malloc);
+
+void mixed_size_allocations_with_256_byte_slabs(benchmark::State& state) {
+    allocator::mmap_memory<256> memory;
+    mixed_size_allocations(state, memory);
+}
+BENCHMARK(mixed_size_allocations_with_256_byte_slabs);
+
+void mixed_size_allocations_with_4_kib_slabs(benchmark::State& state) {
+    allocator::mmap_memory<4096> memory;
+    mixed_size_allocations(state, memory);
+}
+BENCHMARK(mixed_size_allocations_with_4_kib_slabs);
+
+void mixed_size_allocations_with_tiered_memory(benchmark::State& state) {
+    using segment_pool_t = allocator::segment_pool<allocator::mmap_block_allocator<>, 256, 4 * 1024 * 1024>;
+
+    auto pool = std::make_unique<segment_pool_t>();
+    allocator::tiered_memory<segment_pool_t, 256, 4096, 64 * 1024> memory{ *pool };
+    mixed_size_allocations(state, memory);
+}
+BENCHMARK(mixed_size_allocations_with_tiered_memory);
+
+// Replaces one of 4 live buffers of 256 KiB to 1 MiB in every iteration, interleaved with small objects that stay
+// allocated, and reports the bytes spanned by the heap (including its free slabs) at the end.
+template <typename _memory_t>
+void huge_allocations(benchmark::State& state) {
+    const std::size_t live_buffers = 4;
+    auto memory = std::make_unique<_memory_t>();
+    std::mt19937 random{ 42 };
+    std::array<void*, live_buffers> buffers{};
+    std::vector<void*> small_objects;
+    std::size_t next = 0;
+
+    for (auto _ : state) {
+        memory->deallocate(buffers[next]);
+        buffers[next] = memory->allocate(256 * 1024 + random() % (768 * 1024));
+        benchmark::DoNotOptimize(buffers[next]);
+        next = (next + 1) % live_buffers;
+
+        small_objects.push_back(memory->allocate(64));
+    }
+
+    std::size_t heap_size = 0;
+
+    memory->walk_heap([&](const allocator::heap_slab_info& info) {
+        heap_size += info.size;
+    });
+
+    state.counters["heap_size"] = static_cast<double>(heap_size);
+
+    for (auto* const data : buffers) {
+        memory->deallocate(data);
+    }
+
+    for (auto* const data : small_objects) {
+        memory->deallocate(data);
+    }
+}
+
+void huge_allocations_in_slabs(benchmark::State& state) {
+    huge_allocations<allocator::memory<allocator::mmap_block_allocator<>, 1024, 64 * 1024 * 1024>>(state);
+}
+BENCHMARK(huge_allocations_in_slabs);
+
+void huge_allocations_in_direct_mappings(benchmark::State& state) {
+    huge_allocations<allocator::memory<allocator::mmap_block_allocator<>, 1024, 64 * 1024 * 1024, { .direct_mapping_threshold = 64 * 1024 }>>(state);
+}
+BENCHMARK(huge_allocations_in_direct_mappings);
+
+void pmr_map_churn(benchmark::State& state, std::pmr::memory_resource& resource) {
+    std::pmr::map<int, mid_size_object> map{ &resource };
+
+    for (auto _ : state) {
+        for (int i = 0; i < iterations; ++i) {
+            benchmark::DoNotOptimize(map[(i * 7919) % iterations]);
+        }
+
+        for (int i = 0; i < iterations; ++i) {
+            map.erase(i);
+        }
+    }
+}
+
+void pmr_list_churn(benchmark::State& state, std::pmr::memory_resource& resource) {
+    std::pmr::list<int> list{ &resource };
+
+    for (auto _ : state) {
+        for (int i = 0; i < iterations; ++i) {
+            list.push_back(i);
+            benchmark::DoNotOptimize(list.back());
+        }
+
+        while (!list.empty()) {
+            list.pop_front();
+        }
+    }
+}
+
+void pmr_map_with_new_delete_resource(benchmark::State& state) {
+    pmr_map_churn(state, *std::pmr::new_delete_resource());
+}
+BENCHMARK(pmr_map_with_new_delete_resource);
+
+void pmr_map_with_unsynchronized_pool_resource(benchmark::State& state) {
+    std::pmr::unsynchronized_pool_resource resource;
+    pmr_map_churn(state, resource);
+}
+BENCHMARK(pmr_map_with_unsynchronized_pool_resource);
+
+void pmr_map_with_synchronized_pool_resource(benchmark::State& state) {
+    std::pmr::synchronized_pool_resource resource;
+    pmr_map_churn(state, resource);
+}
+BENCHMARK(pmr_map_with_synchronized_pool_resource);
+
+void pmr_map_with_memory_resource(benchmark::State& state) {
+    allocator::mmap_memory<4096> memory;
+    allocator::memory_resource resource{ memory };
+    pmr_map_churn(state, resource);
+}
+BENCHMARK(pmr_map_with_memory_resource);
+
+void pmr_list_with_new_delete_resource(benchmark::State& state) {
+    pmr_list_churn(state, *std::pmr::new_delete_resource());
+}
+BENCHMARK(pmr_list_with_new_delete_resource);
+
+void pmr_list_with_unsynchronized_pool_resource(benchmark::State& state) {
+    std::pmr::unsynchronized_pool_resource resource;
+    pmr_list_churn(state, resource);
+}
+BENCHMARK(pmr_list_with_unsynchronized_pool_resource);
+
+void pmr_list_with_synchronized_pool_resource(benchmark::State& state) {
+    std::pmr::synchronized_pool_resource resource;
+    pmr_list_churn(state, resource);
+}
+BENCHMARK(pmr_list_with_synchronized_pool_resource);
+
+void pmr_list_with_memory_resource(benchmark::State& state) {
+    allocator::mmap_memory<1024> memory;
+    allocator::memory_resource resource{ memory };
+    pmr_list_churn(state, resource);
+}
+BENCHMARK(pmr_list_with_memory_resource);
+
 BENCHMARK_MAIN();
\ No newline at end of file
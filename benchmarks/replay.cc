@@ -0,0 +1,158 @@
+#include "src/allocation_trace.h"
+#include "src/memory.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <vector>
+
+// Replays an allocation trace against different allocators. The trace is loaded from the file passed with
+// --trace=<path> (as saved by trace_recorder::save). Without it, a trace of a synthetic workload is recorded first.
+
+std::vector<allocator::trace_event> trace;
+std::size_t pointer_ids = 0;
+
+// Handles batches of requests, each allocating a number of short-lived objects of mostly small sizes, and keeps
+// some of the objects in a long-lived cache of limited size.
+std::vector<allocator::trace_event> record_synthetic_trace() {
+    allocator::mmap_memory<4096> memory;
+    allocator::traced_memory traced{ memory };
+
+    std::mt19937 random{ 42 };
+    std::geometric_distribution<std::size_t> size_distribution{ 0.02 };
+    std::uniform_int_distribution<std::size_t> objects_distribution{ 1, 64 };
+    std::bernoulli_distribution cache_distribution{ 0.05 };
+
+    std::vector<void*> request;
+    std::vector<void*> cache;
+
+    for (std::size_t i = 0; i < 4 * 1024; ++i) {
+        const auto objects = objects_distribution(random);
+
+        for (std::size_t j = 0; j < objects; ++j) {
+            request.push_back(traced.allocate(16 + 8 * size_distribution(random)));
+        }
+
+        for (auto* const data : request) {
+            if (cache_distribution(random)) {
+                if (cache.size() == 4 * 1024) {
+                    std::swap(cache[random() % cache.size()], cache.back());
+                    traced.deallocate(cache.back());
+                    cache.pop_back();
+                }
+
+                cache.push_back(data);
+            }
+            else {
+                traced.deallocate(data);
+            }
+        }
+
+        request.clear();
+    }
+
+    for (auto* const data : cache) {
+        traced.deallocate(data);
+    }
+
+    return traced.recorder().events();
+}
+
+template <typename _allocate_t, typename _deallocate_t>
+void replay(benchmark::State& state, _allocate_t allocate, _deallocate_t deallocate) {
+    std::vector<std::pair<void*, std::size_t>> pointers(pointer_ids);
+
+    for (auto _ : state) {
+        for (const auto& event : trace) {
+            auto& [data, size] = pointers[event.pointer_id];
+
+            if (event.operation == allocator::trace_operation::allocate) {
+                size = std::max<std::size_t>(event.size, 1);
+                data = allocate(size);
+                benchmark::DoNotOptimize(data);
+            }
+            else if (data) {
+                deallocate(data, size);
+                data = nullptr;
+            }
+        }
+
+        for (auto& [data, size] : pointers) {
+            if (data) {
+                deallocate(data, size);
+                data = nullptr;
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * trace.size());
+}
+
+void replay_with_malloc(benchmark::State& state) {
+    replay(state,
+        [](std::size_t size) { return std::malloc(size); },
+        [](void* data, std::size_t) { std::free(data); });
+}
+BENCHMARK(replay_with_malloc);
+
+void replay_with_memory(benchmark::State& state) {
+    allocator::mmap_memory<4096> memory;
+
+    replay(state,
+        [&](std::size_t size) { return memory.allocate(size); },
+        [&](void* data, std::size_t) { memory.deallocate(data); });
+}
+BENCHMARK(replay_with_memory);
+
+void replay_with_unsynchronized_pool_resource(benchmark::State& state) {
+    std::pmr::unsynchronized_pool_resource resource;
+
+    replay(state,
+        [&](std::size_t size) { return resource.allocate(size); },
+        [&](void* data, std::size_t size) { resource.deallocate(data, size); });
+}
+BENCHMARK(replay_with_unsynchronized_pool_resource);
+
+void replay_with_synchronized_pool_resource(benchmark::State& state) {
+    std::pmr::synchronized_pool_resource resource;
+
+    replay(state,
+        [&](std::size_t size) { return resource.allocate(size); },
+        [&](void* data, std::size_t size) { resource.deallocate(data, size); });
+}
+BENCHMARK(replay_with_synchronized_pool_resource);
+
+int main(int argc, char** argv) {
+    const char* trace_path = nullptr;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--trace=", 8) == 0) {
+            trace_path = argv[i] + 8;
+            std::copy(argv + i + 1, argv + argc, argv + i);
+            --argc;
+            break;
+        }
+    }
+
+    if (trace_path) {
+        std::ifstream stream{ trace_path, std::ios::binary };
+        trace = allocator::load_trace(stream);
+    }
+    else {
+        trace = record_synthetic_trace();
+    }
+
+    for (const auto& event : trace) {
+        pointer_ids = std::max<std::size_t>(pointer_ids, event.pointer_id + 1);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    return 0;
+}
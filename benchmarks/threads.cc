@@ -0,0 +1,334 @@
+#include "src/memory.h"
+#include "src/segment_pool.h"
+#include "src/thread_cache.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Classic multi-threaded allocator benchmarks, run with 1 to 8 threads against malloc, a free_memory_manager
+// (through the memory wrapper) guarded by a single lock, and per-thread thread_caches over a shared segment_pool.
+// Every backend hands out per-thread handles, created before the first iteration and destroyed (after releasing
+// all remaining allocations) after the last one by the first thread.
+
+struct malloc_backend final {
+    struct handle final {
+        void* allocate(const std::size_t size) {
+            return std::malloc(size);
+        }
+
+        void deallocate(void* const data) {
+            std::free(data);
+        }
+    };
+
+    std::unique_ptr<handle> make_handle() {
+        return std::make_unique<handle>();
+    }
+};
+
+struct locked_memory_backend final {
+    struct handle final {
+        void* allocate(const std::size_t size) {
+            std::lock_guard lock{ backend.mutex };
+            return backend.memory.allocate(size);
+        }
+
+        void deallocate(void* const data) {
+            std::lock_guard lock{ backend.mutex };
+            backend.memory.deallocate(data);
+        }
+
+        locked_memory_backend& backend;
+    };
+
+    std::unique_ptr<handle> make_handle() {
+        return std::make_unique<handle>(*this);
+    }
+
+    allocator::mmap_memory<4096> memory;
+    std::mutex mutex;
+};
+
+struct thread_cache_backend final {
+    using segment_pool_t = allocator::segment_pool<allocator::mmap_block_allocator<>, 4096>;
+    using handle = allocator::thread_cache<segment_pool_t>;
+
+    std::unique_ptr<handle> make_handle() {
+        return std::make_unique<handle>(segment_pool);
+    }
+
+    segment_pool_t segment_pool;
+};
+
+template <typename _backend_t>
+struct shared_state final {
+    using handle_t = typename _backend_t::handle;
+
+    static void set_up(const benchmark::State& state) {
+        backend = std::make_unique<_backend_t>();
+
+        for (int i = 0; i < state.threads(); ++i) {
+            handles.push_back(backend->make_handle());
+        }
+    }
+
+    static void tear_down() {
+        handles.clear();
+        backend.reset();
+    }
+
+    static handle_t& handle(const benchmark::State& state) {
+        return *handles[state.thread_index()];
+    }
+
+    static inline std::unique_ptr<_backend_t> backend;
+    static inline std::vector<std::unique_ptr<handle_t>> handles;
+};
+
+std::size_t random_size(std::mt19937& random) {
+    return 16 + random() % 1008;
+}
+
+// Larson-style server simulation: every thread replaces random objects of a shared set with new ones of random
+// sizes, so objects are mostly released by a different thread than the one that allocated them.
+template <typename _backend_t>
+void larson(benchmark::State& state) {
+    using shared_t = shared_state<_backend_t>;
+    static std::array<std::atomic<void*>, 16 * 1024> objects;
+
+    if (state.thread_index() == 0) {
+        shared_t::set_up(state);
+    }
+
+    std::mt19937 random(state.thread_index());
+
+    for (auto _ : state) {
+        auto& handle = shared_t::handle(state);
+
+        for (std::size_t i = 0; i < 1000; ++i) {
+            auto* const data = handle.allocate(random_size(random));
+            auto* const previous = objects[random() % objects.size()].exchange(data, std::memory_order_acq_rel);
+
+            if (previous) {
+                handle.deallocate(previous);
+            }
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        for (auto& object : objects) {
+            if (auto* const data = object.exchange(nullptr)) {
+                shared_t::handle(state).deallocate(data);
+            }
+        }
+
+        shared_t::tear_down();
+    }
+
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+
+// Producers (even threads) allocate objects and pass them to consumers (odd threads) through bounded queues,
+// and consumers release them. A producer releases the objects on its own when its queue is full.
+template <typename _backend_t>
+void producer_consumer(benchmark::State& state) {
+    using shared_t = shared_state<_backend_t>;
+
+    struct queue final {
+        std::array<std::atomic<void*>, 1024> objects;
+        alignas(64) std::atomic<std::size_t> head{ 0 };
+        alignas(64) std::atomic<std::size_t> tail{ 0 };
+    };
+
+    static std::vector<std::unique_ptr<queue>> queues;
+
+    if (state.thread_index() == 0) {
+        shared_t::set_up(state);
+
+        for (int i = 0; i < state.threads() / 2; ++i) {
+            queues.push_back(std::make_unique<queue>());
+        }
+    }
+
+    const auto is_producer = state.thread_index() % 2 == 0;
+    std::mt19937 random(state.thread_index());
+
+    for (auto _ : state) {
+        auto& handle = shared_t::handle(state);
+        auto& pair_queue = *queues[state.thread_index() / 2];
+
+        if (is_producer) {
+            for (std::size_t i = 0; i < 256; ++i) {
+                auto* const data = handle.allocate(random_size(random));
+                const auto tail = pair_queue.tail.load(std::memory_order_relaxed);
+
+                if (tail - pair_queue.head.load(std::memory_order_acquire) == pair_queue.objects.size()) {
+                    handle.deallocate(data);
+                    continue;
+                }
+
+                pair_queue.objects[tail % pair_queue.objects.size()].store(data, std::memory_order_relaxed);
+                pair_queue.tail.store(tail + 1, std::memory_order_release);
+            }
+        }
+        else {
+            const auto tail = pair_queue.tail.load(std::memory_order_acquire);
+            auto head = pair_queue.head.load(std::memory_order_relaxed);
+
+            for (; head != tail; ++head) {
+                handle.deallocate(pair_queue.objects[head % pair_queue.objects.size()].load(std::memory_order_relaxed));
+            }
+
+            pair_queue.head.store(head, std::memory_order_release);
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        for (auto& pair_queue : queues) {
+            for (auto head = pair_queue->head.load(); head != pair_queue->tail.load(); ++head) {
+                shared_t::handle(state).deallocate(pair_queue->objects[head % pair_queue->objects.size()].load());
+            }
+        }
+
+        queues.clear();
+        shared_t::tear_down();
+    }
+
+    if (is_producer) {
+        state.SetItemsProcessed(state.iterations() * 256);
+    }
+}
+
+// Every thread allocates objects of random sizes and releases them in random order, never sharing them.
+template <typename _backend_t>
+void private_churn(benchmark::State& state) {
+    using shared_t = shared_state<_backend_t>;
+
+    if (state.thread_index() == 0) {
+        shared_t::set_up(state);
+    }
+
+    std::mt19937 random(state.thread_index());
+    std::vector<void*> objects(1000);
+
+    for (auto _ : state) {
+        auto& handle = shared_t::handle(state);
+
+        for (auto& data : objects) {
+            data = handle.allocate(random_size(random));
+        }
+
+        std::shuffle(objects.begin(), objects.end(), random);
+
+        for (auto* const data : objects) {
+            handle.deallocate(data);
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        shared_t::tear_down();
+    }
+
+    state.SetItemsProcessed(state.iterations() * objects.size());
+}
+
+// Every iteration starts a short-lived thread (with its own handle) that allocates and releases a few objects.
+template <typename _backend_t>
+void thread_churn(benchmark::State& state) {
+    using shared_t = shared_state<_backend_t>;
+
+    if (state.thread_index() == 0) {
+        shared_t::set_up(state);
+    }
+
+    for (auto _ : state) {
+        std::thread{ [&] {
+            auto handle = shared_t::backend->make_handle();
+            std::mt19937 random(state.thread_index());
+            std::array<void*, 256> objects;
+
+            for (auto& data : objects) {
+                data = handle->allocate(random_size(random));
+            }
+
+            for (auto* const data : objects) {
+                handle->deallocate(data);
+            }
+        } }.join();
+    }
+
+    if (state.thread_index() == 0) {
+        shared_t::tear_down();
+    }
+
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+
+void larson_with_malloc(benchmark::State& state) {
+    larson<malloc_backend>(state);
+}
+BENCHMARK(larson_with_malloc)->ThreadRange(1, 8)->UseRealTime();
+
+void larson_with_locked_memory(benchmark::State& state) {
+    larson<locked_memory_backend>(state);
+}
+BENCHMARK(larson_with_locked_memory)->ThreadRange(1, 8)->UseRealTime();
+
+void larson_with_thread_cache(benchmark::State& state) {
+    larson<thread_cache_backend>(state);
+}
+BENCHMARK(larson_with_thread_cache)->ThreadRange(1, 8)->UseRealTime();
+
+void producer_consumer_with_malloc(benchmark::State& state) {
+    producer_consumer<malloc_backend>(state);
+}
+BENCHMARK(producer_consumer_with_malloc)->DenseThreadRange(2, 8, 2)->UseRealTime();
+
+void producer_consumer_with_locked_memory(benchmark::State& state) {
+    producer_consumer<locked_memory_backend>(state);
+}
+BENCHMARK(producer_consumer_with_locked_memory)->DenseThreadRange(2, 8, 2)->UseRealTime();
+
+void producer_consumer_with_thread_cache(benchmark::State& state) {
+    producer_consumer<thread_cache_backend>(state);
+}
+BENCHMARK(producer_consumer_with_thread_cache)->DenseThreadRange(2, 8, 2)->UseRealTime();
+
+void private_churn_with_malloc(benchmark::State& state) {
+    private_churn<malloc_backend>(state);
+}
+BENCHMARK(private_churn_with_malloc)->ThreadRange(1, 8)->UseRealTime();
+
+void private_churn_with_locked_memory(benchmark::State& state) {
+    private_churn<locked_memory_backend>(state);
+}
+BENCHMARK(private_churn_with_locked_memory)->ThreadRange(1, 8)->UseRealTime();
+
+void private_churn_with_thread_cache(benchmark::State& state) {
+    private_churn<thread_cache_backend>(state);
+}
+BENCHMARK(private_churn_with_thread_cache)->ThreadRange(1, 8)->UseRealTime();
+
+void thread_churn_with_malloc(benchmark::State& state) {
+    thread_churn<malloc_backend>(state);
+}
+BENCHMARK(thread_churn_with_malloc)->ThreadRange(1, 8)->UseRealTime();
+
+void thread_churn_with_locked_memory(benchmark::State& state) {
+    thread_churn<locked_memory_backend>(state);
+}
+BENCHMARK(thread_churn_with_locked_memory)->ThreadRange(1, 8)->UseRealTime();
+
+void thread_churn_with_thread_cache(benchmark::State& state) {
+    thread_churn<thread_cache_backend>(state);
+}
+BENCHMARK(thread_churn_with_thread_cache)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace allocator {
+
+// Point-in-time copy of the counters of a free_memory_manager (see free_memory_manager_options::collect_statistics).
+struct allocation_statistics final {
+    static constexpr std::size_t max_bins = 64;
+
+    // Number of allocations and releases of small elements, per size class (see size_classes::class_index).
+    std::array<std::uint64_t, max_bins> class_allocations{};
+    std::array<std::uint64_t, max_bins> class_deallocations{};
+    // Number of allocations and releases of large (multi-slab) elements, per power of two of their size.
+    std::array<std::uint64_t, max_bins> large_allocations{};
+    std::array<std::uint64_t, max_bins> large_deallocations{};
+
+    // Bytes taken by live elements (including the rounding up to their size class or whole slabs).
+    std::uint64_t live_bytes = 0;
+    // Bytes of all memory segments added to the manager (including slab headers).
+    std::uint64_t reserved_bytes = 0;
+    // Total bytes requested by, and handed out to, all allocations so far.
+    std::uint64_t requested_bytes = 0;
+    std::uint64_t allocated_bytes = 0;
+
+    // Number of empty runs split to carve out (or shrink) a large allocation.
+    std::uint64_t splits = 0;
+    // Number of empty runs merged with a neighbor (or absorbed by a growing allocation).
+    std::uint64_t merges = 0;
+    // Number of allocations that found no free memory (the memory wrapper then grows the pool and retries).
+    std::uint64_t failed_allocations = 0;
+
+    // Bytes lost so far to rounding requests up to their element sizes.
+    std::uint64_t rounding_waste_bytes() const {
+        return allocated_bytes - requested_bytes;
+    }
+};
+
+// Counters of a single free_memory_manager. They are only ever updated by the thread owning the manager, so instead
+// of atomic read-modify-writes every update is a relaxed load and store (a plain add), while still letting
+// snapshot() be polled from any other thread.
+class allocation_counters final {
+public:
+    void record_allocation(const bool is_class, const std::size_t bin, const std::size_t requested_size, const std::size_t element_size, const std::size_t count = 1) {
+        add(is_class ? _class_allocations[bin] : _large_allocations[bin], count);
+        add(_requested_bytes, requested_size * count);
+        add(_allocated_bytes, element_size * count);
+    }
+
+    void record_deallocation(const bool is_class, const std::size_t bin, const std::size_t element_size, const std::size_t count = 1) {
+        add(is_class ? _class_deallocations[bin] : _large_deallocations[bin], count);
+        add(_deallocated_bytes, element_size * count);
+    }
+
+    void record_resize(const std::size_t old_element_size, const std::size_t new_element_size) {
+        add(_resized_bytes, new_element_size - old_element_size);
+    }
+
+    void record_reserved(const std::size_t bytes) {
+        add(_reserved_bytes, bytes);
+    }
+
+    void record_released(const std::size_t bytes) {
+        add(_reserved_bytes, -static_cast<std::uint64_t>(bytes));
+    }
+
+    void record_split() {
+        add(_splits, 1);
+    }
+
+    void record_merge() {
+        add(_merges, 1);
+    }
+
+    void record_failure() {
+        add(_failed_allocations, 1);
+    }
+
+    allocation_statistics snapshot() const {
+        allocation_statistics statistics;
+
+        for (std::size_t bin = 0; bin < allocation_statistics::max_bins; ++bin) {
+            statistics.class_allocations[bin] = load(_class_allocations[bin]);
+            statistics.class_deallocations[bin] = load(_class_deallocations[bin]);
+            statistics.large_allocations[bin] = load(_large_allocations[bin]);
+            statistics.large_deallocations[bin] = load(_large_deallocations[bin]);
+        }
+
+        statistics.live_bytes = load(_allocated_bytes) + load(_resized_bytes) - load(_deallocated_bytes);
+        statistics.reserved_bytes = load(_reserved_bytes);
+        statistics.requested_bytes = load(_requested_bytes);
+        statistics.allocated_bytes = load(_allocated_bytes);
+        statistics.splits = load(_splits);
+        statistics.merges = load(_merges);
+        statistics.failed_allocations = load(_failed_allocations);
+
+        return statistics;
+    }
+
+private:
+    using counter_t = std::atomic<std::uint64_t>;
+
+    static void add(counter_t& counter, const std::uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    static std::uint64_t load(const counter_t& counter) {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    std::array<counter_t, allocation_statistics::max_bins> _class_allocations{};
+    std::array<counter_t, allocation_statistics::max_bins> _class_deallocations{};
+    std::array<counter_t, allocation_statistics::max_bins> _large_allocations{};
+    std::array<counter_t, allocation_statistics::max_bins> _large_deallocations{};
+
+    counter_t _reserved_bytes{ 0 };
+    counter_t _requested_bytes{ 0 };
+    counter_t _allocated_bytes{ 0 };
+    counter_t _deallocated_bytes{ 0 };
+    counter_t _resized_bytes{ 0 };
+    counter_t _splits{ 0 };
+    counter_t _merges{ 0 };
+    counter_t _failed_allocations{ 0 };
+};
+
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace allocator {
+
+enum class trace_operation : std::uint8_t {
+    allocate,
+    deallocate
+};
+
+// Single allocation or release in a saved trace. Every allocation gets a new pointer id, and the release of
+// an allocation refers to it by the same id (so ids are never reused, unlike the addresses of the allocations).
+struct trace_event final {
+    std::uint64_t timestamp;
+    std::uint32_t pointer_id;
+    std::uint64_t size;
+    trace_operation operation;
+};
+
+// Binary trace format: a header with a magic number, a version and the number of events, followed by 21 bytes
+// per event (timestamp, pointer id, size and operation), in native byte order. Version 1 traces (which marked
+// releases with the top bit of a 32-bit size) are no longer read.
+inline constexpr std::uint32_t trace_magic = 0x43525441; // "ATRC"
+inline constexpr std::uint32_t trace_version = 2;
+
+inline void save_trace(std::ostream& stream, const std::vector<trace_event>& events) {
+    const auto write = [&](const auto value) {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    write(trace_magic);
+    write(trace_version);
+    write(static_cast<std::uint64_t>(events.size()));
+
+    for (const auto& event : events) {
+        write(event.timestamp);
+        write(event.pointer_id);
+        write(event.size);
+        write(event.operation);
+    }
+}
+
+inline std::vector<trace_event> load_trace(std::istream& stream) {
+    const auto read = [&]<typename T>(T& value) {
+        if (!stream.read(reinterpret_cast<char*>(&value), sizeof(value)))
+            throw std::runtime_error("truncated allocation trace");
+    };
+
+    std::uint32_t magic, version;
+    std::uint64_t count;
+
+    read(magic);
+    read(version);
+
+    if (magic != trace_magic || version != trace_version)
+        throw std::runtime_error("unsupported allocation trace format");
+
+    read(count);
+
+    std::vector<trace_event> events(count);
+
+    for (auto& event : events) {
+        read(event.timestamp);
+        read(event.pointer_id);
+        read(event.size);
+        read(event.operation);
+
+        if (event.operation != trace_operation::allocate && event.operation != trace_operation::deallocate)
+            throw std::runtime_error("invalid allocation trace operation");
+    }
+
+    return events;
+}
+
+// Records allocations and releases into a ring buffer of _capacity entries, overwriting the oldest entries when
+// full. Recording is a clock read and a few stores; pointers are only turned into pointer ids by save().
+template <std::size_t _capacity = 1024 * 1024>
+class trace_recorder final {
+    static_assert((_capacity & (_capacity - 1)) == 0, "Trace capacity must be a power of two");
+
+public:
+    void record(const trace_operation operation, const void* const data, const std::size_t size = 0) {
+        auto& entry = _entries[_recorded++ & (_capacity - 1)];
+
+        entry.timestamp = static_cast<std::uint64_t>((std::chrono::steady_clock::now() - _start).count());
+        entry.pointer = data;
+        entry.size = size;
+        entry.operation = operation;
+    }
+
+    // Number of entries currently held by the ring buffer.
+    std::size_t size() const {
+        return _recorded < _capacity ? _recorded : _capacity;
+    }
+
+    // Number of entries recorded so far (including the overwritten ones).
+    std::size_t recorded() const {
+        return _recorded;
+    }
+
+    void clear() {
+        _recorded = 0;
+    }
+
+    // Returns the recorded entries, oldest first, with pointers replaced by pointer ids. Releases of allocations
+    // that are no longer in the buffer are dropped.
+    std::vector<trace_event> events() const {
+        std::vector<trace_event> events;
+        std::unordered_map<const void*, std::uint32_t> live_pointers;
+        std::uint32_t next_pointer_id = 0;
+
+        events.reserve(size());
+
+        for (auto index = _recorded - size(); index < _recorded; ++index) {
+            const auto& entry = _entries[index & (_capacity - 1)];
+
+            if (entry.operation == trace_operation::allocate) {
+                live_pointers[entry.pointer] = next_pointer_id;
+                events.push_back({ entry.timestamp, next_pointer_id++, entry.size, entry.operation });
+            }
+            else if (const auto pointer = live_pointers.find(entry.pointer); pointer != live_pointers.end()) {
+                events.push_back({ entry.timestamp, pointer->second, 0, entry.operation });
+                live_pointers.erase(pointer);
+            }
+        }
+
+        return events;
+    }
+
+    // Writes events() in the binary trace format read by load_trace.
+    void save(std::ostream& stream) const {
+        save_trace(stream, events());
+    }
+
+private:
+    struct entry final {
+        std::uint64_t timestamp;
+        const void* pointer;
+        std::size_t size;
+        trace_operation operation;
+    };
+
+    std::vector<entry> _entries = std::vector<entry>(_capacity);
+    std::size_t _recorded{ 0 };
+    std::chrono::steady_clock::time_point _start{ std::chrono::steady_clock::now() };
+};
+
+// Forwards allocations to the wrapped allocator (memory, free_memory_manager or thread_cache) and records them.
+// Does not own the wrapped allocator.
+template <typename _memory_t, std::size_t _capacity = 1024 * 1024>
+class traced_memory final {
+public:
+    explicit traced_memory(_memory_t& memory) : _memory{ memory } {}
+
+    void* allocate(const std::size_t size) {
+        auto* const data = _memory.allocate(size);
+
+        if (data)
+            _recorder.record(trace_operation::allocate, data, size);
+
+        return data;
+    }
+
+    void* allocate(const std::size_t size, const std::size_t alignment) {
+        auto* const data = _memory.allocate(size, alignment);
+
+        if (data)
+            _recorder.record(trace_operation::allocate, data, size);
+
+        return data;
+    }
+
+    void deallocate(void* const data) {
+        if (!data)
+            return;
+
+        _recorder.record(trace_operation::deallocate, data);
+        _memory.deallocate(data);
+    }
+
+    _memory_t& memory() const {
+        return _memory;
+    }
+
+    trace_recorder<_capacity>& recorder() {
+        return _recorder;
+    }
+
+    const trace_recorder<_capacity>& recorder() const {
+        return _recorder;
+    }
+
+private:
+    _memory_t& _memory;
+    trace_recorder<_capacity> _recorder;
+};
+
+}
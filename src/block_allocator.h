@@ -4,7 +4,9 @@
 #include <cstdint>
 #include <stdexcept>
 #include <memory>
+#include <vector>
 
+#include "os_memory.h"
 #include "types.h"
 
 namespace allocator {
@@ -12,6 +14,8 @@ namespace allocator {
 template <std::size_t _size, std::size_t _alignment = alignof(std::max_align_t)>
 class alignas(_alignment) in_place_block_allocator final {
 public:
+    const static auto alignment = _alignment;
+
     allocation_result allocate_at_least(std::size_t size) {
         if (_allocated)
             throw std::runtime_error("memory expansion is not supported");
@@ -34,4 +38,136 @@ private:
     bool _allocated = false;
 };
 
+// Reserves a large range of the virtual address space up front (on the first allocation) and commits it
+// in chunks of _commit_size bytes. Every returned block starts at an address aligned to _alignment and
+// directly follows the previously returned block. If _transparent_huge_pages is set, committed chunks are
+// advised to be backed by transparent huge pages (which requires a 2 MiB alignment to be effective).
+template <std::size_t _reserve_size = 16ull * 1024 * 1024 * 1024, std::size_t _commit_size = 1024 * 1024, std::size_t _alignment = _commit_size, bool _transparent_huge_pages = false>
+class mmap_block_allocator final {
+    static_assert((_alignment & (_alignment - 1)) == 0, "Block alignment must be a power of two");
+    static_assert(_commit_size % _alignment == 0, "Commit size must be a multiple of the block alignment");
+    static_assert(_reserve_size % _commit_size == 0, "Reserve size must be a multiple of the commit size");
+
+public:
+    const static auto alignment = _alignment;
+
+    mmap_block_allocator() = default;
+    mmap_block_allocator(const mmap_block_allocator&) = delete;
+    mmap_block_allocator& operator=(const mmap_block_allocator&) = delete;
+
+    ~mmap_block_allocator() {
+        if (_reservation)
+            os::release(_reservation, _reservation_size);
+    }
+
+    allocation_result allocate_at_least(std::size_t size) {
+        if (!_reservation)
+            reserve();
+
+        const auto count = (size + _commit_size - 1) / _commit_size * _commit_size;
+
+        if (count > _reserve_size - _committed)
+            throw std::runtime_error("reserved address space is exhausted");
+
+        auto* const data = _base + _committed;
+        os::commit(data, count);
+
+        if constexpr (_transparent_huge_pages)
+            os::advise_huge_pages(data, count);
+
+        _last_block = data;
+        _committed += count;
+
+        return { data, count };
+    }
+
+    void deallocate(std::byte* data) {
+        if (data == nullptr || data != _last_block)
+            throw std::runtime_error("only the most recently allocated block can be released");
+
+        const auto count = static_cast<std::size_t>(_base + _committed - data);
+        os::decommit(data, count);
+
+        _committed -= count;
+        _last_block = nullptr;
+    }
+
+private:
+    void reserve() {
+        _reservation_size = _reserve_size + _alignment;
+        _reservation = os::reserve(_reservation_size);
+        _base = reinterpret_cast<std::byte*>(
+            (reinterpret_cast<std::uintptr_t>(_reservation) + _alignment - 1) / _alignment * _alignment);
+    }
+
+    std::byte* _reservation{ nullptr };
+    std::size_t _reservation_size{ 0 };
+    std::byte* _base{ nullptr };
+    std::byte* _last_block{ nullptr };
+    std::size_t _committed{ 0 };
+};
+
+// Maps every block separately, backed by explicit huge pages (MAP_HUGETLB). If the system runs out of
+// explicit huge pages (or does not provide them at all), it falls back to a contiguous reservation backed
+// by transparent huge pages. Either way, every block is aligned to the huge page size.
+template <std::size_t _reserve_size = 16ull * 1024 * 1024 * 1024>
+class huge_page_block_allocator final {
+public:
+    const static auto alignment = os::huge_page_size;
+
+    huge_page_block_allocator() = default;
+    huge_page_block_allocator(const huge_page_block_allocator&) = delete;
+    huge_page_block_allocator& operator=(const huge_page_block_allocator&) = delete;
+
+    ~huge_page_block_allocator() {
+        for (const auto& block : _huge_page_blocks)
+            os::release(block.ptr, block.count);
+    }
+
+    allocation_result allocate_at_least(std::size_t size) {
+        if (!_huge_pages_exhausted) {
+            const auto count = (size + os::huge_page_size - 1) / os::huge_page_size * os::huge_page_size;
+            auto* const data = os::map_huge_pages(count);
+
+            if (data) {
+                _huge_page_blocks.push_back({ data, count });
+                return { data, count };
+            }
+
+            _huge_pages_exhausted = true;
+        }
+
+        return _fallback_allocator.allocate_at_least(size);
+    }
+
+    void deallocate(std::byte* data) {
+        for (auto it = _huge_page_blocks.begin(); it != _huge_page_blocks.end(); ++it) {
+            if (it->ptr == data) {
+                os::release(it->ptr, it->count);
+                _huge_page_blocks.erase(it);
+                return;
+            }
+        }
+
+        _fallback_allocator.deallocate(data);
+    }
+
+    bool uses_explicit_huge_pages() const {
+        return !_huge_page_blocks.empty();
+    }
+
+private:
+    std::vector<allocation_result> _huge_page_blocks;
+    bool _huge_pages_exhausted = false;
+    mmap_block_allocator<_reserve_size, os::huge_page_size, os::huge_page_size, true> _fallback_allocator;
+};
+
+template <typename _allocator_t>
+constexpr std::size_t block_alignment_v = [] {
+    if constexpr (requires { _allocator_t::alignment; })
+        return std::size_t{ _allocator_t::alignment };
+    else
+        return std::size_t{ 1 };
+}();
+
 }
\ No newline at end of file
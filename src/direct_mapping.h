@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "os_memory.h"
+#include "utils.h"
+
+namespace allocator {
+
+// Maps every allocation as a dedicated region of whole pages, aligned to the slab size and laid out as a single
+// slab of _slab_t hosting a single large allocation. The slab header in front of the data is the only overhead,
+// and it lets the owner recognise the region (and its size) from a pointer to its data. Allocated regions are
+// linked through the free_list fields of their headers, so that they can be walked and unmapped on destruction.
+// Released regions are kept mapped in a cache of up to _cached_regions most recently released regions, reused
+// by allocations that need at least half of their size, and the oldest region is unmapped when the cache overflows.
+template <typename _slab_t, std::size_t _cached_regions = 4>
+class direct_mappings final {
+    static_assert(std::is_pointer_v<typename _slab_t::link_t>, "Direct mappings require slab headers with pointer links");
+
+public:
+    using slab_t = _slab_t;
+
+    static constexpr std::size_t region_alignment = _slab_t::memory_slab_alignment;
+
+    direct_mappings() = default;
+    direct_mappings(const direct_mappings&) = delete;
+    direct_mappings& operator=(const direct_mappings&) = delete;
+
+    ~direct_mappings() {
+        while (_regions != nullptr)
+            unmap(std::exchange(_regions, _regions->header.free_list.next));
+
+        while (_cached_count > 0)
+            unmap(_cached[--_cached_count]);
+    }
+
+    // Returns the data block of a region hosting at least size bytes. Throws std::bad_alloc if the system is
+    // out of memory.
+    std::byte* allocate(const std::size_t size) {
+        const auto size_in_region = required_region_size(size);
+        auto* slab = take_cached(size_in_region);
+
+        if (slab == nullptr)
+            slab = map(size_in_region);
+
+        slab->set_element(0);
+
+        slab->header.free_list.previous = nullptr;
+        slab->header.free_list.next = _regions;
+
+        if (_regions != nullptr)
+            _regions->header.free_list.previous = slab;
+
+        _regions = slab;
+
+        return slab->data_block();
+    }
+
+    // Releases the region of the slab, keeping it in the cache (and unmapping the oldest cached region if full).
+    void deallocate(_slab_t* const slab) {
+        assert(slab->has_element(0) && "region must be allocated before release");
+
+        slab->clear_element(0);
+
+        if (slab->header.free_list.previous != nullptr)
+            slab->header.free_list.previous->header.free_list.next = slab->header.free_list.next;
+        else
+            _regions = slab->header.free_list.next;
+
+        if (slab->header.free_list.next != nullptr)
+            slab->header.free_list.next->header.free_list.previous = slab->header.free_list.previous;
+
+        if constexpr (_cached_regions == 0) {
+            unmap(slab);
+        }
+        else {
+            if (_cached_count == _cached_regions) {
+                unmap(_cached[0]);
+                std::shift_left(_cached.begin(), _cached.end(), 1);
+                --_cached_count;
+            }
+
+            _cached[_cached_count++] = slab;
+        }
+    }
+
+    static std::size_t region_size(const _slab_t* const slab) {
+        return slab->header.metadata.element_size + _slab_t::data_block_offset;
+    }
+
+    std::size_t cached_count() const {
+        return _cached_count;
+    }
+
+    // Calls the visitor with the slab of every allocated region, most recently allocated first.
+    template <typename _visitor_t>
+    void for_each_region(_visitor_t&& visitor) const {
+        for (const auto* slab = _regions; slab != nullptr; slab = slab->header.free_list.next) {
+            visitor(slab);
+        }
+    }
+
+private:
+    static std::size_t required_region_size(const std::size_t size) {
+        const auto granularity = std::max(os::page_size(), region_alignment);
+        return (size + _slab_t::data_block_offset + granularity - 1) / granularity * granularity;
+    }
+
+    // Takes the smallest cached region of at least size bytes, if it is no more than twice as large.
+    _slab_t* take_cached(const std::size_t size) {
+        std::size_t best = _cached_count;
+
+        for (std::size_t index = 0; index < _cached_count; ++index) {
+            const auto cached_size = region_size(_cached[index]);
+
+            if (cached_size >= size && cached_size / 2 <= size && (best == _cached_count || cached_size < region_size(_cached[best])))
+                best = index;
+        }
+
+        if (best == _cached_count)
+            return nullptr;
+
+        auto* const slab = _cached[best];
+
+        std::shift_left(_cached.begin() + best, _cached.end(), 1);
+        --_cached_count;
+
+        return slab;
+    }
+
+    // Reserves the region with enough slack to align it, trims the slack and commits the aligned range.
+    static _slab_t* map(const std::size_t size) {
+        const auto slack = region_alignment > os::page_size() ? region_alignment - os::page_size() : 0;
+        auto* const reservation = os::reserve(size + slack);
+        const auto reservation_begin = reinterpret_cast<std::uintptr_t>(reservation);
+        const auto aligned_begin = (reservation_begin + region_alignment - 1) / region_alignment * region_alignment;
+        auto* const region = reservation + (aligned_begin - reservation_begin);
+
+        if (region != reservation)
+            os::release(reservation, region - reservation);
+        if (region + size != reservation + size + slack)
+            os::release(region + size, reservation + size + slack - (region + size));
+
+        os::commit(region, size);
+
+        auto* const slab = std::launder(reinterpret_cast<_slab_t*>(region));
+        launder_slab(slab, size / _slab_t::memory_slab_alignment);
+
+        return slab;
+    }
+
+    static void unmap(_slab_t* const slab) {
+        os::release(reinterpret_cast<std::byte*>(slab), region_size(slab));
+    }
+
+    _slab_t* _regions{ nullptr };
+    std::array<_slab_t*, _cached_regions> _cached{};
+    std::size_t _cached_count{ 0 };
+};
+
+}
@@ -1,103 +1,599 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <chrono>
+#include <functional>
 #include <optional>
 #include <limits>
 #include <stdexcept>
+#include <type_traits>
 #include <cstdint>
 #include <cassert>
+#include <cstring>
 
+#include "allocation_statistics.h"
 #include "memory_slab.h"
+#include "os_memory.h"
+#include "out_of_band_slab.h"
+#include "size_classes.h"
 
 namespace allocator {
 
-template <std::size_t _slab_size = 1024>
+// Selects the empty run a multi-slab (or first slab of a size class) allocation is carved from.
+enum class placement_policy {
+    // Head of the first non-empty bucket large enough (the most recently released run).
+    first_fit,
+    // Smallest run large enough. Runs are kept sorted by size within their buckets.
+    best_fit,
+    // Lowest-addressed run large enough. Runs are kept sorted by address within their buckets.
+    address_ordered
+};
+
+struct free_memory_manager_options final {
+    // Empty slab runs of at least this many bytes have their data pages returned to the system by purge()
+    // (0 disables purging).
+    std::size_t purge_threshold = 0;
+    // If non-zero, purge() is called on its own once at least that many milliseconds have passed since the previous
+    // purge and there are empty runs above the threshold left to purge. The deadline is checked when such a run is
+    // released and on every 64th allocation while it is pending (so a run released within the decay period is
+    // purged by a later allocation). Without it, purge() must be called explicitly.
+    std::size_t purge_decay_ms = 0;
+    // Number of words in the bitmap of allocated elements of each slab. Every word can track 64 elements.
+    std::size_t bitmap_words = 1;
+    // Number of size classes each doubling of small allocation sizes is divided into (1 rounds every request up
+    // to a power of two, 4 follows the jemalloc spacing). See size_classes.
+    std::size_t size_classes_per_doubling = 1;
+    placement_policy placement = placement_policy::first_fit;
+    // Number of lists the partially used slabs of every size class are split into by their occupancy. Small
+    // allocations are served from the fullest slab, letting the nearly empty ones drain and merge back into
+    // empty runs (1 keeps a single list per size class, most recently used slab first).
+    std::size_t occupancy_classes = 1;
+    // Keeps allocation counters that can be read with statistics() (see allocation_statistics).
+    bool collect_statistics = false;
+    // Shifts the first element of small object slabs by a number of cache lines that varies from slab to slab
+    // (within the space left over after the last element), so that the elements with the same index in different
+    // slabs do not all map to the same cache sets.
+    bool cache_colouring = false;
+    // Size of the memory segments added to the manager, a power of two they are aligned to. Only required by
+    // layouts that find slab headers relative to the segment base.
+    std::size_t segment_size = 0;
+    // Keeps slab headers in a table at the beginning of every memory segment (see out_of_band_slab) instead of in
+    // front of the data of every slab. Requires the segment_size.
+    bool out_of_band_headers = false;
+    // Halves the slab headers by storing the links between slabs as 32-bit distances and the element size and
+    // bitmap as 32-bit words (so every bitmap word tracks 32 elements). See compact_slab_link. Runs of slabs, and
+    // so allocations and memory segments, are then limited to 4 GiB (see max_run_size), and all memory segments
+    // added to the manager must lie within 2^31 slabs of each other (128 GiB with 64-byte slabs).
+    bool compact_headers = false;
+    // Allocations that would span more than this many bytes of slabs (including the slab header) are served by the
+    // memory wrapper from dedicated, directly mapped regions instead (see direct_mappings). Must be a multiple of
+    // the slab size (0 disables direct mappings).
+    std::size_t direct_mapping_threshold = 0;
+    // Number of released direct mappings the memory wrapper keeps mapped for reuse.
+    std::size_t cached_direct_mappings = 4;
+};
+
+template <std::size_t _slab_size = 1024, free_memory_manager_options _options = {}>
 class free_memory_manager final {
 private:
     static constexpr std::size_t _max_buckets = std::numeric_limits<std::size_t>::digits;
 
 public:
-    void add_new_memory_segment(memory_slab<_slab_size>* const slab) {
+    using slab_t = std::conditional_t<_options.out_of_band_headers,
+        out_of_band_slab<_slab_size, _options.segment_size, _options.bitmap_words, _options.compact_headers>,
+        memory_slab<_slab_size, _options.bitmap_words, _options.compact_headers>>;
+    using size_classes_t = size_classes<slab_t::data_block_size, _options.size_classes_per_doubling>;
+
+    // Every allocation is aligned to std::max_align_t. Larger alignments are supported up to max_alignment
+    // (the slab size itself if slabs have no header in front of their data).
+    static constexpr std::size_t natural_alignment = alignof(std::max_align_t);
+    static constexpr std::size_t max_alignment = slab_t::data_block_offset == 0
+        ? _slab_size
+        : slab_t::data_block_offset <= _slab_size / 2
+        ? _slab_size / 2
+        : std::size_t{ 1 } << std::countr_zero(slab_t::data_block_offset);
+
+    // Largest run of slabs (header included). Compact headers store the size of a run in a 32-bit word.
+    static constexpr std::size_t max_run_size = _options.compact_headers
+        ? std::size_t{ std::numeric_limits<std::uint32_t>::max() } / _slab_size * _slab_size
+        : std::numeric_limits<std::size_t>::max();
+
+    void add_new_memory_segment(slab_t* const slab) {
         assert(slab != nullptr && "slab must not be null");
         assert(slab->header.neighbors.previous == nullptr && "slab must not have a previous neighbor");
         assert(slab->header.neighbors.next == nullptr && "slab must not have a next neighbor");
 
+        record_reserved(slab);
         add_memory_segment(slab);
     }
 
+    void remove_memory_segment(slab_t* const slab) {
+        assert(slab != nullptr && "slab must not be null");
+        assert(slab->is_empty() && "segment must be fully released before removal");
+        assert(slab->header.neighbors.previous == nullptr && "slab must not have a previous neighbor");
+        assert(slab->header.neighbors.next == nullptr && "slab must not have a next neighbor");
+
+        remove_from_free_list(slab);
+        record_released(slab);
+    }
+
     void* allocate(std::size_t size, const void* = nullptr) {
-        const auto matching_bucket_index = required_size_to_sufficient_bucket_index(size);
+        if constexpr (_options.purge_decay_ms > 0) {
+            if (_unpurged_bytes != 0 && --_purge_check_countdown == 0) {
+                _purge_check_countdown = purge_check_interval;
+                purge_if_decayed();
+            }
+        }
 
-        if (has_bucket_at_index(matching_bucket_index)) {
-            return allocate_from_bucket(matching_bucket_index);
+        if (size < slab_t::data_block_size) {
+            const auto class_index = size_classes_t::class_index(size);
+
+            if (has_class_at_index(class_index)) {
+                record_class_allocation(class_index, size, size_classes_t::class_size(size));
+                return allocate_from_class(class_index);
+            }
+        }
+
+        if constexpr (_options.compact_headers) {
+            if (size > max_run_size || required_segment_size(size) > max_run_size) {
+                record_failure();
+                return nullptr;
+            }
         }
 
         const auto element_size = required_size_to_element_size(size);
-        const auto min_full_slab_index = block_size_to_bucket_index(memory_slab<_slab_size>::data_block_size);
-        const auto min_bucket_index = std::max(matching_bucket_index, min_full_slab_index);
+        const auto min_bucket_index = required_size_to_min_bucket_index(size);
         assert(min_bucket_index < _max_buckets && "minimum bucket index out of range");
 
-        if ((_free_segments_mask >> min_bucket_index) == 0) {
+        const auto data_block_size = std::max(element_size, 0 + slab_t::data_block_size);
+        auto* const slab = find_free_run(data_block_size, min_bucket_index);
+
+        if (slab == nullptr) {
+            record_failure();
             return nullptr;
         }
 
-        const auto bucket_index = std::countr_zero(_free_segments_mask >> min_bucket_index) + min_bucket_index;
-        const auto data_block_size = std::max(element_size, 0 + memory_slab<_slab_size>::data_block_size);
-        assert(bucket_index < _max_buckets && "bucket index out of range");
-        assert(has_bucket_at_index(bucket_index) && "bucket must exist for the given index");
-
-        auto* slab = _free_segments[bucket_index];
-        assert(slab != nullptr && "slab should not be null when bucket is occupied");
         assert(slab->is_empty() && "slab must be empty when allocating from it");
+        assert(slab->header.metadata.element_size >= data_block_size && "run must be large enough for the element");
 
         remove_from_free_list(slab);
-        split_slab_at_offset(slab, data_block_size + memory_slab<_slab_size>::data_block_offset);
 
-        slab->header.metadata.element_size = element_size;
-        slab->header.metadata.full_mask = slab->calculate_full_mask();
+        if (auto* const remaining_slab = split_slab_at_offset(slab, data_block_size + slab_t::data_block_offset)) {
+            add_to_bucket(remaining_slab);
+        }
+
+        slab->reset_elements(element_size);
         slab->set_element(0);
 
         if (!slab->is_full()) {
             add_to_bucket(slab);
         }
 
-        return slab->get_element(0);
+        record_allocation(size, slab->header.metadata.element_size);
+
+        return element_in_slab(slab, 0);
+    }
+
+    // Allocates size bytes aligned to the given power of two. Elements whose (power-of-two multiple) size keeps
+    // them aligned inside a slab are served from regular slabs. Otherwise the object is carved out of an empty run,
+    // right after the first aligned address past the slab header. Returns nullptr for alignments above max_alignment.
+    void* allocate(std::size_t size, std::size_t alignment) {
+        assert(std::has_single_bit(alignment) && "alignment must be a power of two");
+
+        if (alignment > max_alignment) {
+            record_failure();
+            return nullptr;
+        }
+
+        const auto request = aligned_request(size, alignment);
+        auto* const data = static_cast<std::byte*>(allocate(request.size));
+
+        return data ? data + request.padding : nullptr;
+    }
+
+    std::size_t required_segment_size(const std::size_t size, const std::size_t alignment) const {
+        return required_segment_size(aligned_request(size, alignment).size);
+    }
+
+    std::size_t required_segment_size(const std::size_t size) const {
+        const auto min_bucket_index = required_size_to_min_bucket_index(size);
+        const auto data_block_size = std::max(std::size_t{ 1 } << min_bucket_index, required_size_to_element_size(size));
+
+        return (data_block_size + slab_t::data_block_offset + _slab_size - 1) / _slab_size * _slab_size;
     }
 
     void deallocate(void* const data, std::size_t = 0) {
-        auto* const slab_aligned_ptr = reinterpret_cast<void*>(
-            reinterpret_cast<std::size_t>(data) & ~(memory_slab<_slab_size>::memory_slab_alignment - 1));
-        auto* const slab = std::launder(reinterpret_cast<memory_slab<_slab_size>*>(slab_aligned_ptr));
-        const auto element_size = slab->header.metadata.element_size;
-        const auto element_offset = reinterpret_cast<std::size_t>(data)
-            - reinterpret_cast<std::size_t>(slab_aligned_ptr)
-            - memory_slab<_slab_size>::data_block_offset;
-        const auto element_index = element_offset / element_size;
-        const auto was_full = slab->is_full();
-        const auto was_empty = slab->is_empty();
+        auto* const slab = slab_from_pointer(data);
+        const auto element_index = element_index_in_slab(slab, data);
+        const auto occupancy = occupancy_class(slab);
 
         assert(slab->has_element(element_index) && "element must exist in slab before release");
 
         slab->clear_element(element_index);
 
+        record_deallocation(slab->header.metadata.element_size);
+        update_released_slab(slab, occupancy);
+    }
+
+    // Number of bytes that can be used starting at data without reallocating it.
+    std::size_t usable_size(void* const data) const {
+        const auto* const slab = slab_from_pointer(data);
+        const auto element_offset = reinterpret_cast<std::size_t>(data)
+            - reinterpret_cast<std::size_t>(slab->data_block())
+            - colour_offset(slab);
+
+        return slab->header.metadata.element_size - element_offset % slab->header.metadata.element_size;
+    }
+
+    // Resizes the allocation in place. Large allocations grow into the empty run that follows them and shrink
+    // by returning their tail slabs to the manager. Small elements can only be resized within their size class.
+    // Returns false (leaving the allocation untouched) if the allocation cannot be resized in place.
+    bool try_expand(void* const data, std::size_t new_size) {
+        auto* const slab = slab_from_pointer(data);
+        const auto padding = reinterpret_cast<std::size_t>(data)
+            - reinterpret_cast<std::size_t>(slab->get_element(0));
+
+        if (slab->header.metadata.element_size < slab_t::data_block_size) {
+            return new_size <= usable_size(data);
+        }
+
+        const auto required_element_size = required_size_to_element_size(std::max(new_size + padding, 0 + slab_t::data_block_size));
+        const auto original_element_size = slab->header.metadata.element_size;
+
+        if (required_element_size > slab->header.metadata.element_size) {
+            slab_t* const next = slab->header.neighbors.next;
+            const auto available_size = slab->header.metadata.element_size + slab_t::data_block_offset
+                + (next != nullptr ? next->header.metadata.element_size : 0);
+
+            if (next == nullptr || !next->is_empty() || available_size < required_element_size) {
+                return false;
+            }
+
+            remove_from_free_list(next);
+            record_merge();
+
+            slab->header.metadata.element_size = available_size;
+            slab->header.neighbors.next = next->header.neighbors.next;
+
+            if (slab->header.neighbors.next != nullptr) {
+                slab->header.neighbors.next->header.neighbors.previous = slab;
+            }
+        }
+
+        if (auto* const remaining_slab = split_slab_at_offset(slab, required_element_size + slab_t::data_block_offset)) {
+            release_empty_run(remaining_slab);
+        }
+
+        record_resize(original_element_size, slab->header.metadata.element_size);
+
+        return true;
+    }
+
+    // Resizes the allocation, in place if possible (see try_expand), otherwise by moving it to a new allocation.
+    // Only the natural alignment is preserved when the data is moved. Returns nullptr (leaving the original
+    // allocation untouched) if the manager ran out of memory.
+    void* reallocate(void* const data, std::size_t new_size) {
+        if (data == nullptr) {
+            return allocate(new_size);
+        }
+
+        if (try_expand(data, new_size)) {
+            return data;
+        }
+
+        auto* const new_data = allocate(new_size);
+
+        if (new_data == nullptr) {
+            return nullptr;
+        }
+
+        std::memcpy(new_data, data, std::min(usable_size(data), new_size));
+        deallocate(data);
+
+        return new_data;
+    }
+
+    // Allocates up to count elements of the given size, storing their pointers in out. Whole runs of free
+    // elements are claimed from a slab at once. Returns the number of allocated elements, which is lower
+    // than count only if the manager ran out of memory.
+    std::size_t allocate_batch(std::size_t size, std::size_t count, void** const out) {
+        const auto class_index = size < slab_t::data_block_size ? size_classes_t::class_index(size) : _max_classes;
+        std::size_t allocated = 0;
+
+        while (allocated < count) {
+            if (class_index < _max_classes && has_class_at_index(class_index)) {
+                const auto allocated_from_class = allocate_batch_from_class(class_index, count - allocated, out + allocated);
+
+                record_class_allocation(class_index, size, size_classes_t::class_size(size), allocated_from_class);
+                allocated += allocated_from_class;
+                continue;
+            }
+
+            auto* const data = allocate(size);
+
+            if (!data)
+                break;
+
+            out[allocated++] = data;
+        }
+
+        return allocated;
+    }
+
+    // Releases count elements. The pointers are grouped by slab (sorted by address, in chunks of
+    // deallocate_batch_chunk, unless they already are), so that every slab of a chunk has each of its bitmap words
+    // and its bucket updated only once, however the pointers of different slabs are interleaved.
+    void deallocate_batch(void* const* const data, std::size_t count) {
+        std::array<void*, deallocate_batch_chunk> sorted;
+
+        for (std::size_t begin = 0; begin < count; begin += sorted.size()) {
+            const auto chunk = std::min(count - begin, sorted.size());
+
+            if (std::is_sorted(data + begin, data + begin + chunk, std::less<void*>{})) {
+                deallocate_sorted_batch(data + begin, chunk);
+                continue;
+            }
+
+            std::copy_n(data + begin, chunk, sorted.begin());
+            std::sort(sorted.begin(), sorted.begin() + chunk, std::less<void*>{});
+
+            deallocate_sorted_batch(sorted.data(), chunk);
+        }
+    }
+
+    // Returns the data pages of the empty runs above the purge threshold released since the previous purge to the
+    // system. Runs that are still purged are skipped, so every pass only makes system calls for new runs.
+    void purge() {
+        static_assert(_options.purge_threshold > 0, "purging is disabled for this free_memory_manager");
+
+        if (_unpurged_bytes == 0) {
+            return;
+        }
+
+        const auto first_bucket_index = block_size_to_bucket_index(_options.purge_threshold);
+        auto buckets_mask = _free_segments_mask >> first_bucket_index;
+
+        while (buckets_mask != 0) {
+            const auto bucket_index = first_bucket_index + std::countr_zero(buckets_mask);
+            buckets_mask &= buckets_mask - 1;
+
+            for (auto* slab = _free_segments[bucket_index]; slab != nullptr; slab = slab->header.free_list.next) {
+                if (slab->is_empty() && !slab->is_purged() && slab->header.metadata.element_size >= _options.purge_threshold) {
+                    purge_slab_data(slab);
+                    slab->set_purged(true);
+                }
+            }
+        }
+
+        _unpurged_bytes = 0;
+    }
+
+    // Copy of the allocation counters. Unlike the rest of the manager, it can be called from any thread.
+    allocation_statistics statistics() const {
+        static_assert(_options.collect_statistics, "statistics are disabled for this free_memory_manager");
+
+        return _statistics.snapshot();
+    }
+
+private:
+    struct aligned_allocation_request final {
+        std::size_t size;
+        std::size_t padding;
+    };
+
+    aligned_allocation_request aligned_request(const std::size_t size, const std::size_t alignment) const {
+        if (alignment <= natural_alignment) {
+            return { std::max(size, alignment), 0 };
+        }
+
+        if (slab_t::data_block_offset % alignment == 0) {
+            const auto class_size = size_classes_t::class_size((size + alignment - 1) / alignment * alignment);
+            const auto element_size = class_size % alignment == 0 ? class_size : std::bit_ceil(class_size);
+
+            if (element_size < slab_t::data_block_size) {
+                return { element_size, 0 };
+            }
+        }
+
+        const auto padding = (slab_t::data_block_offset + alignment - 1) / alignment * alignment - slab_t::data_block_offset;
+
+        return { std::max(size + padding, 0 + slab_t::data_block_size), padding };
+    }
+
+    slab_t* slab_from_pointer(void* const data) const {
+        return slab_t::from_pointer(data);
+    }
+
+    std::size_t element_index_in_slab(const slab_t* const slab, void* const data) const {
+        const auto element_offset = reinterpret_cast<std::size_t>(data)
+            - reinterpret_cast<std::size_t>(slab->data_block())
+            - colour_offset(slab);
+        return size_classes_t::element_index(element_offset, slab->header.metadata.element_size);
+    }
+
+    std::byte* element_in_slab(slab_t* const slab, const std::size_t element_index) const {
+        return slab->get_element(element_index) + colour_offset(slab);
+    }
+
+    // Offset of the first element of the slab (see free_memory_manager_options::cache_colouring). The colour is
+    // taken from the address of the slab, so that it does not have to be stored in its header.
+    std::size_t colour_offset(const slab_t* const slab) const {
+        if constexpr (_options.cache_colouring) {
+            static constexpr auto colours = make_colours();
+
+            const auto element_size = slab->header.metadata.element_size;
+
+            if (element_size >= slab_t::data_block_size) {
+                return 0;
+            }
+
+            const auto& colour = colours[size_classes_t::class_index(element_size)];
+            return (reinterpret_cast<std::uintptr_t>(slab->data_block()) / _slab_size & colour.mask) * colour.step;
+        }
+        else {
+            return 0;
+        }
+    }
+
+    struct slab_colours final {
+        std::size_t mask;
+        std::size_t step;
+    };
+
+    // The colours of a size class are multiples of a cache line (or of the alignment of the element size, if
+    // larger), up to the number of bytes left over after the last element of a slab - rounded down to a power of
+    // two number of colours.
+    static constexpr auto make_colours() {
+        constexpr std::size_t cache_line_size = 64;
+        std::array<slab_colours, _max_classes> colours{};
+
+        for (std::size_t size = 1; size < slab_t::data_block_size; size = size_classes_t::class_size(size) + 1) {
+            const auto element_size = size_classes_t::class_size(size);
+            const auto elements = std::min(slab_t::data_block_size / element_size, 0 + slab_t::max_bitmap_elements);
+            const auto left_over = slab_t::data_block_size - elements * element_size;
+            const auto step = std::max(cache_line_size, std::size_t{ 1 } << std::countr_zero(element_size));
+
+            colours[size_classes_t::class_index(size)] = { std::bit_floor(left_over / step + 1) - 1, step };
+        }
+
+        return colours;
+    }
+
+    // Releases elements given in address order, so that the pointers into every slab (and into every bitmap word
+    // of a slab) are consecutive.
+    void deallocate_sorted_batch(void* const* const data, const std::size_t count) {
+        std::size_t index = 0;
+
+        while (index < count) {
+            auto* const slab = slab_from_pointer(data[index]);
+            const auto occupancy = occupancy_class(slab);
+            std::size_t released = 0;
+
+            do {
+                const auto word_index = element_index_in_slab(slab, data[index]) / slab_t::bitmap_word_bits;
+                std::size_t elements_mask = 0;
+
+                for (; index < count && slab_from_pointer(data[index]) == slab; ++index) {
+                    const auto element_index = element_index_in_slab(slab, data[index]);
+
+                    if (element_index / slab_t::bitmap_word_bits != word_index)
+                        break;
+
+                    elements_mask |= std::size_t{ 1 } << (element_index % slab_t::bitmap_word_bits);
+                }
+
+                assert(slab->has_elements(word_index, elements_mask) && "elements must exist in slab before release");
+
+                slab->clear_elements(word_index, elements_mask);
+                released += std::popcount(elements_mask);
+            } while (index < count && slab_from_pointer(data[index]) == slab);
+
+            record_deallocation(slab->header.metadata.element_size, released);
+            update_released_slab(slab, occupancy);
+        }
+    }
+
+    // Moves a slab that had elements released to the list matching its new occupancy (or to the empty runs).
+    void update_released_slab(slab_t* const slab, const std::size_t previous_occupancy) {
+        const auto was_full = previous_occupancy == _occupancy_classes;
+
         if (slab->is_empty()) {
             if (!was_full) {
-                remove_from_free_list(slab);
+                unlink_from_class_list(slab, previous_occupancy);
             }
-            slab->header.metadata.element_size = std::max(
-                slab->header.metadata.element_size,
-                0 + memory_slab<_slab_size>::data_block_size
-            );
-            slab->header.metadata.full_mask = 1;
-            add_memory_segment(slab);
-        }
-        else if (was_full) {
-            add_to_bucket(slab);
+            slab->reset_elements(std::max(
+                std::size_t{ slab->header.metadata.element_size },
+                0 + slab_t::data_block_size
+            ));
+
+            release_empty_run(slab);
+        }
+        else if (const auto occupancy = occupancy_class(slab); occupancy != previous_occupancy) {
+            if (!was_full) {
+                unlink_from_class_list(slab, previous_occupancy);
+            }
+            push_to_class_list(slab, occupancy);
         }
     }
 
-private:
-    void add_memory_segment(memory_slab<_slab_size>* const slab) {
+    // Moves a slab that had elements allocated to the list matching its new occupancy (or out of its size class).
+    void update_allocated_slab(slab_t* const slab, const std::size_t previous_occupancy) {
+        const auto occupancy = occupancy_class(slab);
+
+        if (occupancy == previous_occupancy) {
+            return;
+        }
+
+        unlink_from_class_list(slab, previous_occupancy);
+
+        if (occupancy < _occupancy_classes) {
+            push_to_class_list(slab, occupancy);
+        }
+    }
+
+    // Index of the occupancy list of a slab, from 0 (nearly empty) up. Full slabs get _occupancy_classes,
+    // as they are not kept in any list.
+    std::size_t occupancy_class(const slab_t* const slab) const {
+        if constexpr (_occupancy_classes == 1) {
+            return slab->is_full();
+        }
+        else {
+            return slab->count_elements() * _occupancy_classes / slab->max_elements();
+        }
+    }
+
+    std::size_t fullest_occupancy_class(const std::size_t class_index) const {
+        assert(has_class_at_index(class_index) && "size class must have a free slab");
+
+        if constexpr (_occupancy_classes == 1) {
+            return 0;
+        }
+        else {
+            return std::bit_width(_occupancy_masks[class_index]) - 1;
+        }
+    }
+
+    void release_empty_run(slab_t* const slab) {
+        auto* const merged_slab = add_memory_segment(slab);
+
+        if constexpr (_options.purge_threshold > 0) {
+            if (merged_slab->header.metadata.element_size >= _options.purge_threshold) {
+                merged_slab->set_purged(false);
+                _unpurged_bytes += merged_slab->header.metadata.element_size;
+
+                if constexpr (_options.purge_decay_ms > 0) {
+                    purge_if_decayed();
+                }
+            }
+        }
+    }
+
+    void purge_if_decayed() {
+        const auto now = std::chrono::steady_clock::now();
+
+        if (now - _last_purge < std::chrono::milliseconds(_options.purge_decay_ms)) {
+            return;
+        }
+
+        purge();
+        _last_purge = now;
+    }
+
+    void purge_slab_data(slab_t* const slab) {
+        const auto page_size = os::page_size();
+        const auto data_begin = reinterpret_cast<std::uintptr_t>(slab->data_block());
+        const auto data_end = data_begin + slab->header.metadata.element_size;
+        const auto purge_begin = (data_begin + page_size - 1) / page_size * page_size;
+        const auto purge_end = data_end / page_size * page_size;
+
+        if (purge_begin < purge_end) {
+            os::purge(reinterpret_cast<std::byte*>(purge_begin), purge_end - purge_begin);
+        }
+    }
+
+    slab_t* add_memory_segment(slab_t* const slab) {
         assert(slab->is_empty() && "slab must be empty when added to the manager");
         assert(slab->header.free_list.previous == nullptr && "slab must not have a previous free list element");
         assert(slab->header.free_list.next == nullptr && "slab must not have a next free list element");
@@ -105,12 +601,15 @@ private:
         const auto merged_slab = merge_neighbors_into_slab(slab);
 
         add_to_bucket(merged_slab);
+
+        return merged_slab;
     }
 
-    void* allocate_from_bucket(std::size_t bucket_index) {
-        assert(has_bucket_at_index(bucket_index) && "bucket must exist for the given index");
+    void* allocate_from_class(std::size_t class_index) {
+        assert(has_class_at_index(class_index) && "size class must have a free slab");
 
-        auto* const slab = _free_segments[bucket_index];
+        const auto occupancy = fullest_occupancy_class(class_index);
+        auto* const slab = _free_slabs[class_index][occupancy];
         const auto element_index = slab->get_first_free_element();
 
         assert(!slab->has_element(element_index) && "element must not already exist in slab");
@@ -118,34 +617,65 @@ private:
 
         slab->set_element(element_index);
 
-        if (slab->is_full())
-            remove_from_free_list(slab);
+        update_allocated_slab(slab, occupancy);
 
-        return slab->get_element(element_index);
+        return element_in_slab(slab, element_index);
     }
 
-    void split_slab_at_offset(memory_slab<_slab_size>* slab, std::size_t split_offset) {
+    std::size_t allocate_batch_from_class(std::size_t class_index, std::size_t count, void** const out) {
+        assert(has_class_at_index(class_index) && "size class must have a free slab");
+
+        const auto occupancy = fullest_occupancy_class(class_index);
+        auto* const slab = _free_slabs[class_index][occupancy];
+        std::size_t allocated = 0;
+
+        assert(!slab->is_full() && "slab in a size class must have at least one free element");
+
+        while (allocated < count && !slab->is_full()) {
+            const auto word_index = slab->get_first_free_word();
+            auto free_elements_mask = slab->get_free_elements_mask(word_index);
+            std::size_t elements_mask = 0;
+
+            while (free_elements_mask != 0 && allocated < count) {
+                const auto bit_index = std::countr_zero(free_elements_mask);
+                free_elements_mask &= free_elements_mask - 1;
+                elements_mask |= std::size_t{ 1 } << bit_index;
+                out[allocated++] = element_in_slab(slab, word_index * slab_t::bitmap_word_bits + bit_index);
+            }
+
+            slab->set_elements(word_index, elements_mask);
+        }
+
+        update_allocated_slab(slab, occupancy);
+
+        return allocated;
+    }
+
+    // Splits off the slabs past split_offset as a new empty run and returns it (or nullptr if there is nothing to split off).
+    slab_t* split_slab_at_offset(slab_t* slab, std::size_t split_offset) {
         assert(slab != nullptr && "slab must not be null");
-        assert(slab->is_empty() && "slab must be empty when splitting");
+        assert((slab->is_empty() || slab->header.metadata.element_size >= slab_t::data_block_size) && "only empty slabs and large allocations can be split");
         assert(split_offset % _slab_size == 0 && "split offset must be aligned to slab size");
         assert(slab->header.free_list.previous == nullptr && "slab must not have a previous free list element");
         assert(slab->header.free_list.next == nullptr && "slab must not have a next free list element");
 
-        if (slab->header.metadata.element_size + memory_slab<_slab_size>::data_block_offset == split_offset) {
-            return;
+        if (slab->header.metadata.element_size + slab_t::data_block_offset == split_offset) {
+            return nullptr;
         }
 
         const auto original_element_size = slab->header.metadata.element_size;
 
-        auto* slab_ptr = reinterpret_cast<std::byte*>(slab);
-        auto* remaining_slab_ptr = slab_ptr + split_offset;
-        auto* remaining_slab = std::launder(reinterpret_cast<memory_slab<_slab_size>*>(remaining_slab_ptr));
+        auto* remaining_slab = slab->slab_at_offset(split_offset);
+        const auto purged = slab->is_purged();
 
-        slab->header.metadata.element_size = split_offset - memory_slab<_slab_size>::data_block_offset;
+        slab->header.metadata.element_size = split_offset - slab_t::data_block_offset;
 
-        remaining_slab->header.metadata.element_size = original_element_size - split_offset;
-        remaining_slab->header.metadata.mask = 0;
-        remaining_slab->header.metadata.full_mask = 1;
+        remaining_slab->reset_elements(original_element_size - split_offset);
+
+        if constexpr (_options.purge_threshold > 0) {
+            // The pages of the remaining run are not touched by the split.
+            remaining_slab->set_purged(purged);
+        }
 
         remaining_slab->header.neighbors.previous = slab;
         remaining_slab->header.neighbors.next = slab->header.neighbors.next;
@@ -158,34 +688,164 @@ private:
 
         slab->header.neighbors.next = remaining_slab;
 
-        add_to_bucket(remaining_slab);
+        record_split();
+
+        return remaining_slab;
     }
 
-    void add_to_bucket(memory_slab<_slab_size>* slab) {
+    // Partially used slabs are kept per size class, empty runs per power of two of their size.
+    void add_to_bucket(slab_t* slab) {
         assert(slab != nullptr && "slab must not be null");
         assert(slab->header.free_list.previous == nullptr && "slab must not have a previous free list element");
         assert(slab->header.free_list.next == nullptr && "slab must not have a next free list element");
 
-        const auto bucket_index = block_size_to_bucket_index(slab->header.metadata.element_size);
-        auto*& bucket = _free_segments[bucket_index];
+        const auto element_size = slab->header.metadata.element_size;
+
+        if (element_size < slab_t::data_block_size) {
+            push_to_class_list(slab, occupancy_class(slab));
+        }
+        else if constexpr (_options.placement == placement_policy::first_fit) {
+            push_to_free_list(_free_segments, _free_segments_mask, block_size_to_bucket_index(element_size), slab);
+        }
+        else {
+            insert_into_sorted_free_list(block_size_to_bucket_index(element_size), slab);
+        }
+    }
+
+    // Keeps the runs of a bucket sorted by the placement policy, so that the first fitting run is the preferred one.
+    void insert_into_sorted_free_list(const std::size_t bucket_index, slab_t* const slab) {
+        slab_t* previous = nullptr;
+        slab_t* next = _free_segments[bucket_index];
+
+        while (next != nullptr && is_preferred_run(next, slab)) {
+            previous = next;
+            next = next->header.free_list.next;
+        }
+
+        slab->header.free_list.previous = previous;
+        slab->header.free_list.next = next;
+
+        if (next != nullptr) {
+            next->header.free_list.previous = slab;
+        }
+
+        if (previous != nullptr) {
+            previous->header.free_list.next = slab;
+        }
+        else {
+            _free_segments[bucket_index] = slab;
+        }
+
+        _free_segments_mask |= (1ull << bucket_index);
+    }
 
-        if (bucket != nullptr) {
-            bucket->header.free_list.previous = slab;
+    static bool is_preferred_run(const slab_t* const run, const slab_t* const other) {
+        if constexpr (_options.placement == placement_policy::best_fit) {
+            if (run->header.metadata.element_size != other->header.metadata.element_size) {
+                return run->header.metadata.element_size < other->header.metadata.element_size;
+            }
         }
 
-        slab->header.free_list.next = bucket;
-        bucket = slab;
-        _free_segments_mask |= (1 << bucket_index);
+        return std::less<const slab_t*>{}(run, other);
     }
 
-    void remove_from_free_list(memory_slab<_slab_size>* slab) {
-        const auto bucket_index = block_size_to_bucket_index(slab->header.metadata.element_size);
+    // Returns the empty run (still in its bucket) a data block of the given size should be carved from, or nullptr.
+    // Runs in buckets from min_bucket_index up are always large enough. The best fit and address ordered policies
+    // also consider the fitting runs of the bucket below, as they are sorted and can be searched for the first fit.
+    slab_t* find_free_run(const std::size_t data_block_size, const std::size_t min_bucket_index) const {
+        const auto buckets_mask = min_bucket_index < _max_buckets ? _free_segments_mask >> min_bucket_index : 0;
+
+        if constexpr (_options.placement == placement_policy::first_fit) {
+            if (buckets_mask == 0) {
+                return nullptr;
+            }
+
+            return _free_segments[std::countr_zero(buckets_mask) + min_bucket_index];
+        }
+        else {
+            slab_t* run = nullptr;
+            const auto fitting_bucket_index = block_size_to_bucket_index(data_block_size);
+
+            if (fitting_bucket_index < min_bucket_index) {
+                for (auto* candidate = _free_segments[fitting_bucket_index]; candidate != nullptr; candidate = candidate->header.free_list.next) {
+                    if (candidate->header.metadata.element_size >= data_block_size) {
+                        run = candidate;
+                        break;
+                    }
+                }
+            }
+
+            if constexpr (_options.placement == placement_policy::best_fit) {
+                if (run != nullptr || buckets_mask == 0) {
+                    return run;
+                }
+
+                return _free_segments[std::countr_zero(buckets_mask) + min_bucket_index];
+            }
+            else {
+                for (auto mask = buckets_mask; mask != 0; mask &= mask - 1) {
+                    auto* const candidate = _free_segments[std::countr_zero(mask) + min_bucket_index];
 
-        assert(bucket_index < _max_buckets && "bucket index out of range");
-        assert(has_bucket_at_index(bucket_index) && "bucket must exist for the given index");
+                    if (run == nullptr || std::less<const slab_t*>{}(candidate, run)) {
+                        run = candidate;
+                    }
+                }
 
-        auto* const prev = slab->header.free_list.previous;
-        auto* const next = slab->header.free_list.next;
+                return run;
+            }
+        }
+    }
+
+    void remove_from_free_list(slab_t* slab) {
+        const auto element_size = slab->header.metadata.element_size;
+
+        if (element_size < slab_t::data_block_size) {
+            unlink_from_class_list(slab, occupancy_class(slab));
+        }
+        else {
+            unlink_from_free_list(_free_segments, _free_segments_mask, block_size_to_bucket_index(element_size), slab);
+        }
+    }
+
+    void push_to_class_list(slab_t* const slab, const std::size_t occupancy) {
+        const auto class_index = size_classes_t::class_index(slab->header.metadata.element_size);
+
+        push_to_free_list(_free_slabs[class_index], _occupancy_masks[class_index], occupancy, slab);
+        _free_slabs_mask[class_index / 64] |= (1ull << class_index % 64);
+    }
+
+    void unlink_from_class_list(slab_t* const slab, const std::size_t occupancy) {
+        const auto class_index = size_classes_t::class_index(slab->header.metadata.element_size);
+
+        unlink_from_free_list(_free_slabs[class_index], _occupancy_masks[class_index], occupancy, slab);
+
+        if (_occupancy_masks[class_index] == 0) {
+            _free_slabs_mask[class_index / 64] &= ~(1ull << class_index % 64);
+        }
+    }
+
+    template <std::size_t _free_lists>
+    static void push_to_free_list(std::array<slab_t*, _free_lists>& free_lists, std::uint64_t& mask, std::size_t index, slab_t* slab) {
+        assert(index < _free_lists && "free list index out of range");
+
+        auto*& free_list = free_lists[index];
+
+        if (free_list != nullptr) {
+            free_list->header.free_list.previous = slab;
+        }
+
+        slab->header.free_list.next = free_list;
+        free_list = slab;
+        mask |= (1ull << index);
+    }
+
+    template <std::size_t _free_lists>
+    static void unlink_from_free_list(std::array<slab_t*, _free_lists>& free_lists, std::uint64_t& mask, std::size_t index, slab_t* slab) {
+        assert(index < _free_lists && "free list index out of range");
+        assert((mask & (1ull << index)) && "free list must not be empty");
+
+        slab_t* const prev = slab->header.free_list.previous;
+        slab_t* const next = slab->header.free_list.next;
 
         if (prev != nullptr) {
             prev->header.free_list.next = next;
@@ -195,30 +855,31 @@ private:
             next->header.free_list.previous = prev;
         }
 
-        if (_free_segments[bucket_index] == slab) {
-            _free_segments[bucket_index] = next;
+        if (free_lists[index] == slab) {
+            free_lists[index] = next;
         }
 
         if (next == nullptr && prev == nullptr) {
-            _free_segments_mask &= ~(1ull << bucket_index);
+            mask &= ~(1ull << index);
         }
 
         slab->header.free_list.previous = nullptr;
         slab->header.free_list.next = nullptr;
     }
 
-    memory_slab<_slab_size>* merge_neighbors_into_slab(memory_slab<_slab_size>* slab) {
+    slab_t* merge_neighbors_into_slab(slab_t* slab) {
         assert(slab != nullptr && "slab must not be null");
         assert(slab->is_empty() && "slab must be empty when merging neighbors");
         assert(slab->header.free_list.previous == nullptr && "slab must not have a previous free list element");
         assert(slab->header.free_list.next == nullptr && "slab must not have a next free list element");
 
-        auto* const prev = slab->header.neighbors.previous;
+        slab_t* const prev = slab->header.neighbors.previous;
         if (prev != nullptr && prev->is_empty()) {
             remove_from_free_list(prev);
+            record_merge();
 
             prev->header.metadata.element_size += slab->header.metadata.element_size +
-                memory_slab<_slab_size>::data_block_offset;
+                slab_t::data_block_offset;
 
             prev->header.neighbors.next = slab->header.neighbors.next;
             if (prev->header.neighbors.next != nullptr) {
@@ -228,12 +889,13 @@ private:
             slab = prev;
         }
 
-        auto* const next = slab->header.neighbors.next;
+        slab_t* const next = slab->header.neighbors.next;
         if (next != nullptr && next->is_empty()) {
             remove_from_free_list(next);
+            record_merge();
 
             slab->header.metadata.element_size += next->header.metadata.element_size +
-                memory_slab<_slab_size>::data_block_offset;
+                slab_t::data_block_offset;
 
             slab->header.neighbors.next = next->header.neighbors.next;
             if (slab->header.neighbors.next != nullptr) {
@@ -244,16 +906,85 @@ private:
         return slab;
     }
 
+    void record_allocation(const std::size_t requested_size, const std::size_t element_size) {
+        if constexpr (_options.collect_statistics) {
+            const auto is_class = element_size < slab_t::data_block_size;
+            const auto bin = is_class ? size_classes_t::class_index(element_size) : block_size_to_bucket_index(element_size);
+
+            _statistics.record_allocation(is_class, bin, requested_size, element_size);
+        }
+    }
+
+    void record_class_allocation(const std::size_t class_index, const std::size_t requested_size, const std::size_t element_size, const std::size_t count = 1) {
+        if constexpr (_options.collect_statistics) {
+            _statistics.record_allocation(true, class_index, requested_size, element_size, count);
+        }
+    }
+
+    void record_deallocation(const std::size_t element_size, const std::size_t count = 1) {
+        if constexpr (_options.collect_statistics) {
+            const auto is_class = element_size < slab_t::data_block_size;
+            const auto bin = is_class ? size_classes_t::class_index(element_size) : block_size_to_bucket_index(element_size);
+
+            _statistics.record_deallocation(is_class, bin, element_size, count);
+        }
+    }
+
+    void record_resize(const std::size_t old_element_size, const std::size_t new_element_size) {
+        if constexpr (_options.collect_statistics) {
+            _statistics.record_resize(old_element_size, new_element_size);
+        }
+    }
+
+    void record_reserved(const slab_t* const slab) {
+        if constexpr (_options.collect_statistics) {
+            _statistics.record_reserved(slab->header.metadata.element_size + slab_t::data_block_offset);
+        }
+    }
+
+    void record_released(const slab_t* const slab) {
+        if constexpr (_options.collect_statistics) {
+            _statistics.record_released(slab->header.metadata.element_size + slab_t::data_block_offset);
+        }
+    }
+
+    void record_split() {
+        if constexpr (_options.collect_statistics) {
+            _statistics.record_split();
+        }
+    }
+
+    void record_merge() {
+        if constexpr (_options.collect_statistics) {
+            _statistics.record_merge();
+        }
+    }
+
+    void record_failure() {
+        if constexpr (_options.collect_statistics) {
+            _statistics.record_failure();
+        }
+    }
+
     constexpr inline std::size_t required_size_to_sufficient_bucket_index(const std::size_t size) const {
         return std::bit_width(size - 1);
     }
 
+    // Index of the first bucket whose empty runs are all large enough to host the element of the given size.
+    constexpr inline std::size_t required_size_to_min_bucket_index(const std::size_t size) const {
+        const auto min_full_slab_index = block_size_to_bucket_index(slab_t::data_block_size);
+
+        return required_size_to_element_size(size) < slab_t::data_block_size
+            ? min_full_slab_index
+            : std::max(required_size_to_sufficient_bucket_index(size), min_full_slab_index);
+    }
+
     constexpr inline std::size_t required_size_to_element_size(const std::size_t size) const {
-        const auto element_size = (1ull << required_size_to_sufficient_bucket_index(size));
-        return element_size < memory_slab<_slab_size>::data_block_size
+        const auto element_size = size_classes_t::class_size(size);
+        return element_size < slab_t::data_block_size
             ? element_size
-            : (size + memory_slab<_slab_size>::data_block_offset + _slab_size - 1) / _slab_size * _slab_size -
-            memory_slab<_slab_size>::data_block_offset;
+            : (size + slab_t::data_block_offset + _slab_size - 1) / _slab_size * _slab_size -
+            slab_t::data_block_offset;
     }
 
     constexpr inline std::size_t block_size_to_bucket_index(const std::size_t size) const {
@@ -264,10 +995,37 @@ private:
         return _free_segments_mask & (1ull << bucket_index);
     }
 
-    std::array<memory_slab<_slab_size>*, _max_buckets> _free_segments{};
+    bool inline has_class_at_index(const std::size_t class_index) const {
+        return _free_slabs_mask[class_index / 64] & (1ull << class_index % 64);
+    }
+
+    static constexpr std::size_t _max_classes = size_classes_t::count();
+    static constexpr std::size_t _occupancy_classes = _options.occupancy_classes;
+
+    // Partially used slabs of every size class, split by occupancy (see occupancy_class).
+    std::array<std::array<slab_t*, _occupancy_classes>, _max_classes> _free_slabs{};
+    std::array<std::uint64_t, _max_classes> _occupancy_masks{};
+    // Bit set for every size class with partially used slabs, in as many words as there are classes.
+    std::array<std::uint64_t, (_max_classes + 63) / 64> _free_slabs_mask{};
+
+    std::array<slab_t*, _max_buckets> _free_segments{};
     std::uint64_t _free_segments_mask{ 0 };
 
+    static constexpr std::size_t purge_check_interval = 64;
+    static constexpr std::size_t deallocate_batch_chunk = 256;
+
+    std::size_t _unpurged_bytes{ 0 };
+    std::size_t _purge_check_countdown{ purge_check_interval };
+    std::chrono::steady_clock::time_point _last_purge{};
+
+    struct disabled_counters final {};
+    [[no_unique_address]] std::conditional_t<_options.collect_statistics, allocation_counters, disabled_counters> _statistics{};
+
     static_assert(_max_buckets <= sizeof(_free_segments_mask) * 8, "Too many buckets for free segments manager");
+    static_assert(!_options.collect_statistics || _max_classes <= allocation_statistics::max_bins, "Too many size classes to collect statistics for");
+    static_assert(_occupancy_classes >= 1, "At least one occupancy class is required");
+    static_assert(!_options.out_of_band_headers || _options.segment_size >= 2 * _slab_size, "Out of band headers require a segment size");
+    static_assert(_occupancy_classes <= sizeof(_occupancy_masks[0]) * 8, "Too many occupancy classes for free segments manager");
 
     friend class FreeMemoryManagerTest;
 };
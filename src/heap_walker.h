@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <map>
+#include <ostream>
+
+#include "memory_slab.h"
+
+namespace allocator {
+
+enum class slab_state {
+    // Empty run of one or more slabs, owned by the free memory manager.
+    free_run,
+    // Single slab divided into elements of a size class.
+    small_objects,
+    // One or more slabs hosting a single large allocation.
+    large_allocation
+};
+
+// State of a slab (or a run of slabs) reported by the heap walk.
+struct heap_slab_info final {
+    const void* address;
+    std::size_t segment_index;
+    slab_state state;
+    // Number of slabs and bytes spanned by the slab or run, including its header.
+    std::size_t slabs;
+    std::size_t size;
+    std::size_t element_size;
+    // Number of allocated elements and the number of elements the slab can host.
+    std::size_t elements;
+    std::size_t max_elements;
+};
+
+template <typename _slab_t>
+heap_slab_info describe_slab(const _slab_t* const slab, const std::size_t segment_index) {
+    const auto element_size = slab->header.metadata.element_size;
+    const auto state = slab->is_empty()
+        ? slab_state::free_run
+        : element_size < _slab_t::data_block_size ? slab_state::small_objects : slab_state::large_allocation;
+
+    const auto size = state == slab_state::small_objects ? 0 + _slab_t::memory_slab_alignment : element_size + _slab_t::data_block_offset;
+
+    return {
+        .address = slab->data_block() - _slab_t::data_block_offset,
+        .segment_index = segment_index,
+        .state = state,
+        .slabs = size / _slab_t::memory_slab_alignment,
+        .size = size,
+        .element_size = element_size,
+        .elements = slab->count_elements(),
+        .max_elements = slab->max_elements(),
+    };
+}
+
+// Calls the visitor with the heap_slab_info of every slab (or run of slabs) of the memory segment starting at
+// first_slab, in address order. The segment must not be modified during the walk.
+template <typename _slab_t, typename _visitor_t>
+void walk_segment(const _slab_t* const first_slab, const std::size_t segment_index, _visitor_t&& visitor) {
+    for (const auto* slab = first_slab; slab != nullptr; slab = slab->header.neighbors.next) {
+        visitor(describe_slab(slab, segment_index));
+    }
+}
+
+// Prints one line per memory segment with one character per slab: '.' for free slabs, '#' for the first slab of
+// a large allocation and '=' for its remaining slabs, and the occupancy of small object slabs as a digit from
+// '0' (below 10%) to '9' (90% and more, including full slabs).
+template <typename _heap_t>
+void print_fragmentation_map(std::ostream& stream, const _heap_t& heap, const std::size_t slabs_per_line = 64) {
+    std::size_t current_segment = 0;
+    std::size_t column = 0;
+    bool has_slabs = false;
+
+    const auto put = [&](const char symbol) {
+        if (column == slabs_per_line) {
+            stream << '\n';
+            column = 0;
+        }
+
+        stream << symbol;
+        ++column;
+    };
+
+    heap.walk_heap([&](const heap_slab_info& info) {
+        if (has_slabs && info.segment_index != current_segment) {
+            stream << '\n';
+            column = 0;
+        }
+
+        current_segment = info.segment_index;
+        has_slabs = true;
+
+        switch (info.state) {
+        case slab_state::free_run:
+            for (std::size_t i = 0; i < info.slabs; ++i)
+                put('.');
+            break;
+        case slab_state::small_objects:
+            put(static_cast<char>('0' + std::min<std::size_t>(info.elements * 10 / info.max_elements, 9)));
+            break;
+        case slab_state::large_allocation:
+            put('#');
+            for (std::size_t i = 1; i < info.slabs; ++i)
+                put('=');
+            break;
+        }
+    });
+
+    if (has_slabs) {
+        stream << '\n';
+    }
+}
+
+// Prints the number of slabs (or runs) and the number of bytes they span, grouped by state and element size.
+// Small object slabs are grouped by their size class, large allocations and free runs by the power of two of
+// their size. Also prints the share of free bytes outside of the largest free run and the share of the bytes
+// of small object slabs that are not taken by allocated elements.
+template <typename _heap_t>
+void print_size_histogram(std::ostream& stream, const _heap_t& heap) {
+    struct histogram_bin final {
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+        std::size_t used_bytes = 0;
+    };
+
+    std::map<std::size_t, histogram_bin> small_objects;
+    std::map<std::size_t, histogram_bin> large_allocations;
+    std::map<std::size_t, histogram_bin> free_runs;
+    std::size_t largest_free_run = 0;
+
+    heap.walk_heap([&](const heap_slab_info& info) {
+        switch (info.state) {
+        case slab_state::free_run: {
+            auto& bin = free_runs[std::bit_floor(info.size)];
+            ++bin.count;
+            bin.bytes += info.size;
+            largest_free_run = std::max(largest_free_run, info.size);
+            break;
+        }
+        case slab_state::small_objects: {
+            auto& bin = small_objects[info.element_size];
+            ++bin.count;
+            bin.bytes += info.size;
+            bin.used_bytes += info.elements * info.element_size;
+            break;
+        }
+        case slab_state::large_allocation: {
+            auto& bin = large_allocations[std::bit_floor(info.size)];
+            ++bin.count;
+            bin.bytes += info.size;
+            break;
+        }
+        }
+    });
+
+    const auto print_bins = [&](const char* const title, const std::map<std::size_t, histogram_bin>& bins) {
+        histogram_bin total;
+
+        stream << title << '\n';
+
+        for (const auto& [size, bin] : bins) {
+            stream << "  " << size << ": " << bin.count << " (" << bin.bytes << " bytes)\n";
+            total.count += bin.count;
+            total.bytes += bin.bytes;
+            total.used_bytes += bin.used_bytes;
+        }
+
+        return total;
+    };
+
+    const auto small_objects_total = print_bins("small object slabs by element size:", small_objects);
+    print_bins("large allocations by size:", large_allocations);
+    const auto free_runs_total = print_bins("free runs by size:", free_runs);
+
+    const auto small_objects_waste = small_objects_total.bytes
+        ? 1.0 - static_cast<double>(small_objects_total.used_bytes) / small_objects_total.bytes
+        : 0.0;
+    const auto fragmentation = free_runs_total.bytes
+        ? 1.0 - static_cast<double>(largest_free_run) / free_runs_total.bytes
+        : 0.0;
+
+    stream << "small object slab waste: " << small_objects_waste << '\n';
+    stream << "free space fragmentation: " << fragmentation << '\n';
+}
+
+}
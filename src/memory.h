@@ -2,11 +2,14 @@
 
 #include <span>
 #include <cstdint>
+#include <cstring>
 #include <stdexcept>
 #include <cassert>
 
 #include "block_allocator.h"
+#include "direct_mapping.h"
 #include "free_memory_manager.h"
+#include "heap_walker.h"
 #include "utils.h"
 
 namespace allocator {
@@ -17,30 +20,105 @@ concept allocator = requires(_allocator_t allocator, std::byte * data, std::size
     { allocator.deallocate(data) };
 };
 
-template <allocator _allocator_t, std::size_t _slab_size = 1024, std::size_t _min_allocation_size = 1>
+template <allocator _allocator_t, std::size_t _slab_size = 1024, std::size_t _min_allocation_size = 1, free_memory_manager_options _options = {}>
 class memory final {
 public:
+    using slab_t = typename free_memory_manager<_slab_size, _options>::slab_t;
+
+    static_assert(_options.direct_mapping_threshold % _slab_size == 0, "Direct mapping threshold must be a multiple of the slab size");
+    static_assert(_options.direct_mapping_threshold == 0 || !_options.out_of_band_headers, "Direct mappings require slab headers in front of the data");
+
     void* allocate(size_t size) {
+        if constexpr (_options.direct_mapping_threshold > 0) {
+            if (is_direct_mapping_size(size))
+                return _direct_mappings.allocate(size);
+        }
+
         auto* const data = _free_memory_manager.allocate(size);
 
         if (data)
             return data;
 
-        allocate_new_block(size);
+        const auto segment_size = _free_memory_manager.required_segment_size(size);
+
+        if (!fits_in_run(size, segment_size))
+            return nullptr;
+
+        allocate_new_block(segment_size);
 
         return _free_memory_manager.allocate(size);
     }
 
+    void* allocate(size_t size, size_t alignment) {
+        if (alignment > free_memory_manager<_slab_size, _options>::max_alignment)
+            return nullptr;
+
+        if constexpr (_options.direct_mapping_threshold > 0) {
+            const auto padding = (slab_t::data_block_offset + alignment - 1) / alignment * alignment - slab_t::data_block_offset;
+
+            if (is_direct_mapping_size(size + padding))
+                return _direct_mappings.allocate(size + padding) + padding;
+        }
+
+        auto* const data = _free_memory_manager.allocate(size, alignment);
+
+        if (data)
+            return data;
+
+        const auto segment_size = _free_memory_manager.required_segment_size(size, alignment);
+
+        if (!fits_in_run(size, segment_size))
+            return nullptr;
+
+        allocate_new_block(segment_size);
+
+        return _free_memory_manager.allocate(size, alignment);
+    }
+
     template <typename T, typename... Args>
     T* allocate(Args&&... args) {
-        const auto size = alignof(T) > sizeof(T) || alignof(T) > alignof(std::max_align_t)
-            ? sizeof(T) + alignof(T)
-            : sizeof(T);
+        static_assert(alignof(T) <= free_memory_manager<_slab_size, _options>::max_alignment, "alignment of T exceeds the maximum supported alignment");
+
+        auto* const allocated = alignof(T) > alignof(std::max_align_t)
+            ? allocate(sizeof(T), alignof(T))
+            : allocate(sizeof(T));
 
-        auto* const allocated = allocate(sizeof(T));
         return new (allocated) T(std::forward<Args>(args)...);
     }
 
+    // Resizes the allocation in place if possible, otherwise moves it to a new allocation (see free_memory_manager::reallocate).
+    // Direct mappings are only kept in place if they are large enough, and slab allocations are never expanded past
+    // the direct mapping threshold.
+    void* reallocate(void* const data, size_t size) {
+        if (!data)
+            return allocate(size);
+
+        if (is_direct_mapping(data)) {
+            if (is_direct_mapping_size(size) && size <= _free_memory_manager.usable_size(data))
+                return data;
+        }
+        else if (!is_direct_mapping_size(size + free_memory_manager<_slab_size, _options>::max_alignment) && _free_memory_manager.try_expand(data, size)) {
+            return data;
+        }
+
+        auto* const new_data = allocate(size);
+
+        if (!new_data)
+            return nullptr;
+
+        std::memcpy(new_data, data, std::min(_free_memory_manager.usable_size(data), size));
+        release(data);
+
+        return new_data;
+    }
+
+    void deallocate(void* const data) {
+        if (!data)
+            return;
+
+        release(data);
+    }
+
     template <typename T>
     void deallocate(const T* const data) {
         if (!data)
@@ -50,39 +128,156 @@ public:
 
         data->~T();
 
-        _free_memory_manager.deallocate(reinterpret_cast<void*>(non_const_data));
+        release(reinterpret_cast<void*>(non_const_data));
+    }
+
+    void purge() {
+        _free_memory_manager.purge();
+    }
+
+    // Calls the visitor with the heap_slab_info of every slab (or run of slabs) of every block allocated so far,
+    // starting with the most recently allocated block (see walk_segment), followed by every direct mapping
+    // (reported as a segment of its own).
+    template <typename _visitor_t>
+    void walk_heap(_visitor_t&& visitor) const {
+        std::size_t segment_index = 0;
+
+        for (const auto* current = &_last_block; current && current->_ptr; current = current->_next) {
+            if constexpr (_options.out_of_band_headers) {
+                for (auto* segment = first_segment_in_block(current->_ptr); segment + _options.segment_size <= current->_ptr + current->_size; segment += _options.segment_size) {
+                    walk_segment(slab_t::first_in_segment(segment), segment_index++, visitor);
+                }
+            }
+            else {
+                walk_segment(first_slab_in_block(current->_ptr), segment_index++, visitor);
+            }
+        }
+
+        if constexpr (_options.direct_mapping_threshold > 0) {
+            _direct_mappings.for_each_region([&](const slab_t* const slab) {
+                visitor(describe_slab(slab, segment_index++));
+            });
+        }
+    }
+
+    // Allocation counters of the underlying free_memory_manager (requires the collect_statistics option).
+    allocation_statistics statistics() const {
+        return _free_memory_manager.statistics();
     }
 
 private:
-    void allocate_new_block(size_t size) {
-        const auto allocation_size = std::max(alignof(memory_slab<_slab_size>) + (std::max(size + sizeof(block), 0 + memory_slab<_slab_size>::data_block_size) + sizeof(memory_slab<_slab_size>::data_block_offset)) * 2, _min_allocation_size);
+    // Direct mappings are recognised by their element size, which only they can make reach the threshold, as all
+    // slab allocations span at most direct_mapping_threshold bytes (including the header).
+    static bool is_direct_mapping_size(const size_t size) {
+        return _options.direct_mapping_threshold > 0 && size > _options.direct_mapping_threshold - slab_t::data_block_offset;
+    }
+
+    bool is_direct_mapping(void* const data) const {
+        return _options.direct_mapping_threshold > 0 && slab_t::from_pointer(data)->header.metadata.element_size >= _options.direct_mapping_threshold;
+    }
+
+    void release(void* const data) {
+        if constexpr (_options.direct_mapping_threshold > 0) {
+            if (is_direct_mapping(data)) {
+                _direct_mappings.deallocate(slab_t::from_pointer(data));
+                return;
+            }
+        }
+
+        _free_memory_manager.deallocate(data);
+    }
+
+    // Slab headers cannot describe runs above free_memory_manager::max_run_size, so such requests get no new block.
+    static bool fits_in_run(const size_t size, const size_t segment_size) {
+        constexpr auto max_run_size = free_memory_manager<_slab_size, _options>::max_run_size;
+
+        return size <= max_run_size && segment_size <= max_run_size;
+    }
+
+    void allocate_new_block(size_t segment_size) {
+        if constexpr (_options.out_of_band_headers) {
+            allocate_new_segments(segment_size);
+            return;
+        }
+
+        const auto slab_alignment = slab_t::memory_slab_alignment;
+        const auto alignment_padding = block_alignment_v<_allocator_t> >= slab_alignment ? 0 : slab_alignment - block_alignment_v<_allocator_t>;
+        const auto block_record_size = _slab_size;
+        const auto allocation_size = std::max(alignment_padding + segment_size + block_record_size, _min_allocation_size);
         const auto allocation_result = _allocator.allocate_at_least(allocation_size);
-        auto* const aligned_data = reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(allocation_result.ptr) / memory_slab<_slab_size>::memory_slab_alignment * memory_slab<_slab_size>::memory_slab_alignment);
-        const auto slab_count = (allocation_size - (reinterpret_cast<std::uintptr_t>(aligned_data) - reinterpret_cast<std::uintptr_t>(allocation_result.ptr))) / sizeof(memory_slab<_slab_size>);
+        auto* const slab = first_slab_in_block(allocation_result.ptr);
+        const auto slab_count = std::min<size_t>(
+            (allocation_result.ptr + allocation_result.count - reinterpret_cast<std::byte*>(slab)) / sizeof(slab_t),
+            free_memory_manager<_slab_size, _options>::max_run_size / sizeof(slab_t));
 
         assert(slab_count >= 1 && "aligned size must be at least the size of memory_slab");
 
-        auto* const slab = std::launder(reinterpret_cast<memory_slab<_slab_size>*>(aligned_data));
         launder_slab(slab, slab_count);
 
         _free_memory_manager.add_new_memory_segment(slab);
 
+        add_block(allocation_result);
+    }
+
+    // With out of band headers, every segment keeps its header table at its (segment aligned) beginning, so the
+    // block is split into as many whole segments as fit. Allocations that do not fit into the slabs of a single
+    // segment cannot be served.
+    void allocate_new_segments(size_t segment_size) {
+        const auto alignment_padding = block_alignment_v<_allocator_t> >= _options.segment_size ? 0 : _options.segment_size - block_alignment_v<_allocator_t>;
+        const auto allocation_size = std::max(alignment_padding + _options.segment_size, _min_allocation_size);
+
+        if (segment_size > slab_t::slab_count * _slab_size)
+            return;
+
+        const auto allocation_result = _allocator.allocate_at_least(allocation_size);
+        const auto block_end = allocation_result.ptr + allocation_result.count;
+
+        for (auto* segment = first_segment_in_block(allocation_result.ptr); segment + _options.segment_size <= block_end; segment += _options.segment_size) {
+            _free_memory_manager.add_new_memory_segment(launder_header_table<slab_t>(segment));
+        }
+
+        add_block(allocation_result);
+    }
+
+    void add_block(const allocation_result allocation_result) {
+        block* previous_block = nullptr;
+
         if (_last_block._ptr) {
-            auto* const new_block = allocate<block>();
-            *new_block = _last_block;
+            previous_block = allocate<block>();
+            *previous_block = _last_block;
         }
 
         _last_block._ptr = allocation_result.ptr;
-        _last_block._next = nullptr;
+        _last_block._size = allocation_result.count;
+        _last_block._next = previous_block;
+    }
+
+    static slab_t* first_slab_in_block(std::byte* const block_ptr) {
+        const auto slab_alignment = slab_t::memory_slab_alignment;
+        const auto block_begin = reinterpret_cast<std::uintptr_t>(block_ptr);
+        const auto aligned_begin = (block_begin + slab_alignment - 1) / slab_alignment * slab_alignment;
+
+        return std::launder(reinterpret_cast<slab_t*>(aligned_begin));
+    }
+
+    static std::byte* first_segment_in_block(std::byte* const block_ptr) {
+        const auto block_begin = reinterpret_cast<std::uintptr_t>(block_ptr);
+        const auto aligned_begin = (block_begin + _options.segment_size - 1) / _options.segment_size * _options.segment_size;
+
+        return block_ptr + (aligned_begin - block_begin);
     }
 
     _allocator_t _allocator{};
-    free_memory_manager<_slab_size> _free_memory_manager{};
+    free_memory_manager<_slab_size, _options> _free_memory_manager{};
+
+    struct disabled_direct_mappings final {};
+    [[no_unique_address]] std::conditional_t<_options.direct_mapping_threshold != 0, direct_mappings<slab_t, _options.cached_direct_mappings>, disabled_direct_mappings> _direct_mappings{};
 
     struct block {
         std::byte* _ptr;
+        std::size_t _size;
         block* _next;
-    } _last_block{ nullptr, nullptr };
+    } _last_block{ nullptr, 0, nullptr };
 
     friend struct AllocatorTest;
 };
@@ -90,4 +285,10 @@ private:
 template <std::size_t _size = 16 * 1024, std::size_t _slab_size = 1024>
 using in_place_memory = memory<in_place_block_allocator<_size, _size>, _slab_size>;
 
+template <std::size_t _slab_size = 1024>
+using mmap_memory = memory<mmap_block_allocator<>, _slab_size>;
+
+template <std::size_t _slab_size = 1024>
+using huge_page_memory = memory<huge_page_block_allocator<>, _slab_size, os::huge_page_size>;
+
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+namespace allocator {
+
+// std::pmr adapter over any of the allocators of this library (memory, free_memory_manager, thread_cache).
+// The resource does not own the wrapped allocator, and two resources compare equal if they wrap the same one.
+template <typename _memory_t>
+class memory_resource final : public std::pmr::memory_resource {
+public:
+    explicit memory_resource(_memory_t& memory) : _memory{ memory } {}
+
+    _memory_t& memory() const {
+        return _memory;
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        auto* const data = _memory.allocate(bytes, alignment);
+
+        if (!data)
+            throw std::bad_alloc();
+
+        return data;
+    }
+
+    void do_deallocate(void* data, std::size_t, std::size_t) override {
+        _memory.deallocate(data);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        const auto* const other_resource = dynamic_cast<const memory_resource*>(&other);
+        return other_resource != nullptr && &other_resource->_memory == &_memory;
+    }
+
+    _memory_t& _memory;
+};
+
+}
\ No newline at end of file
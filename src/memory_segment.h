@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "memory_slab.h"
+
+namespace allocator {
+
+template <std::size_t _segment_size = 1024 * 1024, std::size_t _slab_size = 1024>
+struct alignas(_slab_size) memory_segment final {
+    static_assert((_segment_size & (_segment_size - 1)) == 0, "Memory segment size must be a power of two");
+    static_assert(_segment_size >= 2 * _slab_size, "Memory segment must fit its header and at least one slab");
+
+    struct header final {
+        void* owner;
+        memory_segment* previous;
+        memory_segment* next;
+    } header;
+
+    const static auto memory_segment_alignment = _segment_size;
+    const static auto slab_count = _segment_size / _slab_size - 1;
+
+    std::byte padding[_slab_size - sizeof(header)];
+
+    memory_slab<_slab_size>* slabs() {
+        return std::launder(reinterpret_cast<memory_slab<_slab_size>*>(reinterpret_cast<std::byte*>(this) + _slab_size));
+    }
+
+    static memory_segment* from_pointer(const void* const data) {
+        auto* const segment_aligned_ptr = reinterpret_cast<void*>(
+            reinterpret_cast<std::uintptr_t>(data) & ~(memory_segment_alignment - 1));
+        return std::launder(reinterpret_cast<memory_segment*>(segment_aligned_ptr));
+    }
+};
+
+static_assert(sizeof(memory_segment<4096, 256>) == 256);
+static_assert(std::is_trivial_v<memory_segment<4096, 256>>);
+
+}
\ No newline at end of file
@@ -1,31 +1,277 @@
 #pragma once
 
+#include <bit>
+#include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
 #include <type_traits>
 #include <algorithm>
 
 namespace allocator {
 
-template <std::size_t _size = 1024>
+// Hierarchical bitmap of slab elements: each bit of the summary masks describes one of the bitmap words.
+// Compact headers use 32-bit words (and element sizes).
+template <std::size_t _bitmap_words, typename _word_t = std::size_t>
+struct memory_slab_metadata final {
+    _word_t element_size;
+    _word_t mask;                 // bit set for every bitmap word with at least one allocated element
+    _word_t full_mask;            // bit set for every full bitmap word
+    _word_t full_words_mask;      // value of the full_mask if the slab was full
+    _word_t last_word_full_mask;  // value of the last used bitmap word if it was full
+    _word_t words[_bitmap_words];
+};
+
+template <typename _word_t>
+struct memory_slab_metadata<1, _word_t> final {
+    _word_t element_size;
+    _word_t mask;
+    _word_t full_mask;
+};
+
+// Link to another slab kept in a compact header: the signed distance (in slabs) between the data blocks of the
+// slab holding the link and of the linked slab, with 0 standing for no slab. As its value depends on where it is
+// stored, it cannot be copied out of the header - it is read and written as a plain slab pointer instead. Linked
+// slabs must be less than 2^31 slabs apart, which the manager leaves to the placement of its memory segments.
+template <typename _slab_t>
+struct compact_slab_link final {
+    compact_slab_link() = default;
+    compact_slab_link(const compact_slab_link&) = delete;
+
+    compact_slab_link& operator=(const compact_slab_link& other) {
+        return *this = static_cast<_slab_t*>(other);
+    }
+
+    compact_slab_link& operator=(_slab_t* const slab) {
+        if (slab == nullptr) {
+            distance = 0;
+            return *this;
+        }
+
+        const auto slabs = (slab->data_block() - owner()->data_block()) / slab_size();
+
+        assert(slabs != 0 && "slab must not link to itself");
+        assert(slabs >= std::numeric_limits<std::int32_t>::min() && slabs <= std::numeric_limits<std::int32_t>::max() && "linked slabs must be less than 2^31 slabs apart");
+
+        distance = static_cast<std::int32_t>(slabs);
+        return *this;
+    }
+
+    operator _slab_t*() const {
+        return distance != 0 ? _slab_t::from_pointer(owner()->data_block() + distance * slab_size()) : nullptr;
+    }
+
+    _slab_t* operator->() const {
+        return *this;
+    }
+
+    std::int32_t distance;
+
+private:
+    static constexpr std::ptrdiff_t slab_size() {
+        return static_cast<std::ptrdiff_t>(_slab_t::memory_slab_alignment);
+    }
+
+    _slab_t* owner() const {
+        return _slab_t::from_header_address(this);
+    }
+};
+
+// Element bitmap operations shared by the slab layouts, over a _slab_t providing the header (with its metadata),
+// the data_block() holding the elements and the data_block_size. The slabs forward their element methods here
+// instead of inheriting them, which keeps memory_slab an aggregate without bases.
+template <typename _slab_t, std::size_t _bitmap_words, typename _word_t = std::size_t>
+struct memory_slab_elements final {
+    static_assert(_bitmap_words >= 1 && _bitmap_words <= std::numeric_limits<_word_t>::digits, "Unsupported number of bitmap words");
+
+    using metadata_t = memory_slab_metadata<_bitmap_words, _word_t>;
+
+    const static auto bitmap_word_bits = std::size_t{ std::numeric_limits<_word_t>::digits };
+    const static auto max_bitmap_elements = bitmap_word_bits * _bitmap_words;
+
+    static std::size_t max_elements(const metadata_t& metadata) {
+        return std::min(std::max<std::size_t>(1, _slab_t::data_block_size / metadata.element_size), 0 + max_bitmap_elements);
+    }
+
+    static std::size_t calculate_full_mask(const metadata_t& metadata) {
+        return low_bits_mask(std::min(max_elements(metadata), 0 + bitmap_word_bits));
+    }
+
+    // Sets the element size and marks all elements as free.
+    static void reset_elements(metadata_t& metadata, std::size_t element_size) {
+        assert(element_size <= std::numeric_limits<_word_t>::max() && "element size must fit into the slab header");
+
+        metadata.element_size = static_cast<_word_t>(element_size);
+        metadata.mask = 0;
+
+        if constexpr (_bitmap_words == 1) {
+            metadata.full_mask = static_cast<_word_t>(calculate_full_mask(metadata));
+        }
+        else {
+            const auto elements = max_elements(metadata);
+            const auto words = (elements + bitmap_word_bits - 1) / bitmap_word_bits;
+
+            metadata.full_mask = 0;
+            metadata.full_words_mask = static_cast<_word_t>(low_bits_mask(words));
+            metadata.last_word_full_mask = static_cast<_word_t>(low_bits_mask(elements - (words - 1) * bitmap_word_bits));
+            std::fill_n(metadata.words, words, 0);
+        }
+    }
+
+    static bool is_empty(const metadata_t& metadata) {
+        return metadata.mask == 0;
+    }
+
+    static bool is_full(const metadata_t& metadata) {
+        if constexpr (_bitmap_words == 1)
+            return metadata.mask == metadata.full_mask;
+        else
+            return metadata.full_mask == metadata.full_words_mask;
+    }
+
+    static std::size_t count_elements(const metadata_t& metadata) {
+        if constexpr (_bitmap_words == 1) {
+            return std::popcount(metadata.mask);
+        }
+        else {
+            std::size_t count = 0;
+
+            for (auto mask = metadata.mask; mask != 0; mask &= mask - 1)
+                count += std::popcount(metadata.words[std::countr_zero(mask)]);
+
+            return count;
+        }
+    }
+
+    static bool has_element(const metadata_t& metadata, std::size_t index) {
+        return has_elements(metadata, index / bitmap_word_bits, std::size_t{ 1 } << (index % bitmap_word_bits));
+    }
+
+    static std::size_t get_first_free_element(const metadata_t& metadata) {
+        const auto word_index = get_first_free_word(metadata);
+        return word_index * bitmap_word_bits + std::countr_one(word(metadata, word_index));
+    }
+
+    static std::byte* get_element(_slab_t& slab, std::size_t index) {
+        return slab.data_block() + index * slab.header.metadata.element_size;
+    }
+
+    static void set_element(metadata_t& metadata, std::size_t index) {
+        set_elements(metadata, index / bitmap_word_bits, std::size_t{ 1 } << (index % bitmap_word_bits));
+    }
+
+    static void clear_element(metadata_t& metadata, std::size_t index) {
+        clear_elements(metadata, index / bitmap_word_bits, std::size_t{ 1 } << (index % bitmap_word_bits));
+    }
+
+    // Empty runs host no elements, so the full mask of their bitmap is free to record that the data pages of the
+    // run were returned to the system. Resetting the elements clears the mark.
+    static bool is_purged(const metadata_t& metadata) {
+        return is_empty(metadata) && metadata.full_mask == static_cast<_word_t>(~_word_t{ 0 });
+    }
+
+    static void set_purged(metadata_t& metadata, bool purged) {
+        assert(is_empty(metadata) && "only empty runs can be purged");
+
+        if (purged)
+            metadata.full_mask = static_cast<_word_t>(~_word_t{ 0 });
+        else if constexpr (_bitmap_words == 1)
+            metadata.full_mask = static_cast<_word_t>(calculate_full_mask(metadata));
+        else
+            metadata.full_mask = 0;
+    }
+
+    static std::size_t get_first_free_word(const metadata_t& metadata) {
+        if constexpr (_bitmap_words == 1)
+            return 0;
+        else
+            return std::countr_one(metadata.full_mask);
+    }
+
+    static std::size_t get_free_elements_mask(const metadata_t& metadata, std::size_t word_index) {
+        return full_word_mask(metadata, word_index) & ~word(metadata, word_index);
+    }
+
+    static bool has_elements(const metadata_t& metadata, std::size_t word_index, std::size_t elements_mask) {
+        return (word(metadata, word_index) & elements_mask) == elements_mask;
+    }
+
+    static void set_elements(metadata_t& metadata, std::size_t word_index, std::size_t elements_mask) {
+        if constexpr (_bitmap_words == 1) {
+            metadata.mask |= static_cast<_word_t>(elements_mask);
+        }
+        else {
+            auto& word = metadata.words[word_index];
+            word |= static_cast<_word_t>(elements_mask);
+
+            metadata.mask |= _word_t{ 1 } << word_index;
+            if (word == full_word_mask(metadata, word_index))
+                metadata.full_mask |= _word_t{ 1 } << word_index;
+        }
+    }
+
+    static void clear_elements(metadata_t& metadata, std::size_t word_index, std::size_t elements_mask) {
+        if constexpr (_bitmap_words == 1) {
+            metadata.mask &= static_cast<_word_t>(~elements_mask);
+        }
+        else {
+            auto& word = metadata.words[word_index];
+            word &= static_cast<_word_t>(~elements_mask);
+
+            metadata.full_mask &= static_cast<_word_t>(~(_word_t{ 1 } << word_index));
+            if (word == 0)
+                metadata.mask &= static_cast<_word_t>(~(_word_t{ 1 } << word_index));
+        }
+    }
+
+private:
+    static std::size_t low_bits_mask(std::size_t bits) {
+        return bits >= bitmap_word_bits ? std::size_t{ static_cast<_word_t>(~_word_t{ 0 }) } : (std::size_t{ 1 } << bits) - 1;
+    }
+
+    static std::size_t word(const metadata_t& metadata, std::size_t word_index) {
+        if constexpr (_bitmap_words == 1)
+            return metadata.mask;
+        else
+            return metadata.words[word_index];
+    }
+
+    static std::size_t full_word_mask(const metadata_t& metadata, std::size_t word_index) {
+        if constexpr (_bitmap_words == 1)
+            return metadata.full_mask;
+        else
+            return (metadata.full_words_mask >> word_index) > 1 ? low_bits_mask(bitmap_word_bits) : metadata.last_word_full_mask;
+    }
+};
+
+template <bool _compact_headers>
+using slab_word_t = std::conditional_t<_compact_headers, std::uint32_t, std::size_t>;
+
+template <typename _slab_t, bool _compact_headers>
+using slab_link_t = std::conditional_t<_compact_headers, compact_slab_link<_slab_t>, _slab_t*>;
+
+// Slab with its header stored in front of its data block. Compact headers (see compact_slab_link) take 28 instead
+// of 56 bytes, at the cost of 32-bit bitmap words.
+template <std::size_t _size = 1024, std::size_t _bitmap_words = 1, bool _compact_headers = false>
 struct alignas(_size) memory_slab final {
     static_assert((_size& (_size - 1)) == 0, "Memory slab size must be a power of two");
 
+    using link_t = slab_link_t<memory_slab, _compact_headers>;
+    using elements_t = memory_slab_elements<memory_slab, _bitmap_words, slab_word_t<_compact_headers>>;
+
     struct header final {
         struct neighbors final {
-            memory_slab* previous;
-            memory_slab* next;
+            link_t previous;
+            link_t next;
         } neighbors;
 
         struct free_list final {
-            memory_slab* previous;
-            memory_slab* next;
+            link_t previous;
+            link_t next;
         } free_list;
 
-        struct metadata {
-            std::size_t element_size;
-            std::size_t mask;
-            std::size_t full_mask;
-        } metadata;
+        memory_slab_metadata<_bitmap_words, slab_word_t<_compact_headers>> metadata;
     } header;
 
     const static auto memory_slab_alignment = _size;
@@ -33,55 +279,125 @@ struct alignas(_size) memory_slab final {
     const static auto data_block_padding = sizeof(header) % min_required_data_block_align == 0 ? 0 : min_required_data_block_align - sizeof(header) % min_required_data_block_align;
     const static auto data_block_offset = sizeof(header) + data_block_padding;
     const static auto data_block_size = _size - data_block_offset;
+    const static auto bitmap_word_bits = elements_t::bitmap_word_bits;
+    const static auto max_bitmap_elements = elements_t::max_bitmap_elements;
 
     std::byte padding[data_block_padding];
     std::byte data[data_block_size];
 
+    std::byte* data_block() {
+        return data;
+    }
+
+    const std::byte* data_block() const {
+        return data;
+    }
+
     std::size_t max_elements() const {
-        return std::max(1ul, sizeof(data) / header.metadata.element_size);
+        return elements_t::max_elements(header.metadata);
     }
 
     std::size_t calculate_full_mask() const {
-        return (1 << max_elements()) - 1;
+        return elements_t::calculate_full_mask(header.metadata);
+    }
+
+    // Sets the element size and marks all elements as free.
+    void reset_elements(std::size_t element_size) {
+        elements_t::reset_elements(header.metadata, element_size);
     }
 
     bool is_empty() const {
-        return header.metadata.mask == 0;
+        return elements_t::is_empty(header.metadata);
     }
 
     bool is_full() const {
-        return header.metadata.mask == header.metadata.full_mask;
+        return elements_t::is_full(header.metadata);
+    }
+
+    std::size_t count_elements() const {
+        return elements_t::count_elements(header.metadata);
     }
 
     bool has_element(std::size_t index) const {
-        return header.metadata.mask & (1 << index);
+        return elements_t::has_element(header.metadata, index);
     }
 
     std::size_t get_first_free_element() const {
-        return std::countr_one(header.metadata.mask);
+        return elements_t::get_first_free_element(header.metadata);
     }
 
     std::byte* get_element(std::size_t index) {
-        return data + index * header.metadata.element_size;
+        return elements_t::get_element(*this, index);
     }
 
     void set_element(std::size_t index) {
-        header.metadata.mask |= (1 << index);
+        elements_t::set_element(header.metadata, index);
     }
 
     void clear_element(std::size_t index) {
-        header.metadata.mask &= ~(1 << index);
+        elements_t::clear_element(header.metadata, index);
+    }
+
+    // Whether the data pages of an empty run were returned to the system (see memory_slab_elements::is_purged).
+    bool is_purged() const {
+        return elements_t::is_purged(header.metadata);
+    }
+
+    void set_purged(bool purged) {
+        elements_t::set_purged(header.metadata, purged);
+    }
+
+    std::size_t get_first_free_word() const {
+        return elements_t::get_first_free_word(header.metadata);
+    }
+
+    std::size_t get_free_elements_mask(std::size_t word_index) const {
+        return elements_t::get_free_elements_mask(header.metadata, word_index);
+    }
+
+    bool has_elements(std::size_t word_index, std::size_t elements_mask) const {
+        return elements_t::has_elements(header.metadata, word_index, elements_mask);
+    }
+
+    void set_elements(std::size_t word_index, std::size_t elements_mask) {
+        elements_t::set_elements(header.metadata, word_index, elements_mask);
+    }
+
+    void clear_elements(std::size_t word_index, std::size_t elements_mask) {
+        elements_t::clear_elements(header.metadata, word_index, elements_mask);
+    }
+
+    // Slab starting offset bytes past the beginning of this one.
+    memory_slab* slab_at_offset(std::size_t offset) {
+        return std::launder(reinterpret_cast<memory_slab*>(reinterpret_cast<std::byte*>(this) + offset));
+    }
+
+    static memory_slab* from_pointer(const void* const data) {
+        auto* const slab_aligned_ptr = reinterpret_cast<void*>(
+            reinterpret_cast<std::uintptr_t>(data) & ~(memory_slab_alignment - 1));
+        return std::launder(reinterpret_cast<memory_slab*>(slab_aligned_ptr));
+    }
+
+    // Slab whose header contains the given address.
+    static memory_slab* from_header_address(const void* const address) {
+        return from_pointer(address);
     }
 };
 
 static_assert(std::alignment_of_v<memory_slab<64>> == 64);
 static_assert(std::alignment_of_v<memory_slab<1024>> == 1024);
 static_assert(std::is_trivial_v<memory_slab<64>>);
+static_assert(std::is_trivial_v<memory_slab<4096, 8>>);
 
 // Compiler-specific sanity checks
 static_assert(sizeof(memory_slab<128>::min_required_data_block_align) == 8);
 static_assert(sizeof(memory_slab<128>::header) == 56);
 static_assert(offsetof(memory_slab<128>, data) == 64);
 static_assert(sizeof(memory_slab<128>) == 128);
+static_assert(sizeof(memory_slab<4096, 8>::header) == 136);
+static_assert(memory_slab<4096, 8>::data_block_offset == 144);
+static_assert(sizeof(memory_slab<64, 1, true>::header) == 28);
+static_assert(memory_slab<64, 1, true>::data_block_offset == 32);
+static_assert(memory_slab<4096, 8, true>::data_block_offset == 80);
 
 }
\ No newline at end of file
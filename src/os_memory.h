@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace allocator::os {
+
+constexpr std::size_t huge_page_size = 2 * 1024 * 1024;
+
+inline std::size_t page_size() {
+    static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+// Reserves a range of the virtual address space without backing it with any physical memory.
+inline std::byte* reserve(const std::size_t size) {
+    auto* const data = ::mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (data == MAP_FAILED)
+        throw std::bad_alloc();
+
+    return static_cast<std::byte*>(data);
+}
+
+// Maps a committed range backed by explicit (hugetlbfs) huge pages. Returns nullptr if the system has no
+// huge pages available. The size must be a multiple of the huge page size.
+inline std::byte* map_huge_pages(const std::size_t size) {
+    auto* const data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (data == MAP_FAILED)
+        return nullptr;
+
+    return static_cast<std::byte*>(data);
+}
+
+// Makes a previously reserved range accessible. The pages are faulted in lazily on first touch.
+inline void commit(std::byte* const data, const std::size_t size) {
+    if (::mprotect(data, size, PROT_READ | PROT_WRITE) != 0)
+        throw std::bad_alloc();
+}
+
+// Returns the physical pages of a committed range back to the system and makes the range inaccessible.
+inline void decommit(std::byte* const data, const std::size_t size) {
+    ::madvise(data, size, MADV_DONTNEED);
+    ::mprotect(data, size, PROT_NONE);
+}
+
+// Returns the physical pages of a committed range back to the system while keeping the range accessible.
+// The pages are re-faulted (zero-filled) on the next touch.
+inline void purge(std::byte* const data, const std::size_t size) {
+    ::madvise(data, size, MADV_DONTNEED);
+}
+
+// Asks the kernel to back the range with transparent huge pages. It is only a hint - if transparent
+// huge pages are disabled, the range stays backed by regular pages.
+inline void advise_huge_pages(std::byte* const data, const std::size_t size) {
+    ::madvise(data, size, MADV_HUGEPAGE);
+}
+
+inline void release(std::byte* const data, const std::size_t size) {
+    ::munmap(data, size);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "memory_slab.h"
+
+namespace allocator {
+
+// Slab whose header is kept out of band, in a table at the beginning of its memory segment (a block of
+// _segment_size bytes aligned to its size). The slabs that follow the table are pure data, so elements can use
+// the whole slab and allocator state never shares a cache line with user data. A slab object is an entry of
+// the header table, found for any pointer into the slab by its offset from the segment base. Compact headers
+// (see compact_slab_link) shrink the table entries from 56 to 28 bytes.
+template <std::size_t _size = 1024, std::size_t _segment_size = 1024 * 1024, std::size_t _bitmap_words = 1, bool _compact_headers = false>
+struct out_of_band_slab final {
+    static_assert((_size & (_size - 1)) == 0, "Memory slab size must be a power of two");
+    static_assert((_segment_size & (_segment_size - 1)) == 0, "Memory segment size must be a power of two");
+
+    using link_t = slab_link_t<out_of_band_slab, _compact_headers>;
+    using elements_t = memory_slab_elements<out_of_band_slab, _bitmap_words, slab_word_t<_compact_headers>>;
+
+    struct header final {
+        struct neighbors final {
+            link_t previous;
+            link_t next;
+        } neighbors;
+
+        struct free_list final {
+            link_t previous;
+            link_t next;
+        } free_list;
+
+        memory_slab_metadata<_bitmap_words, slab_word_t<_compact_headers>> metadata;
+    } header;
+
+    static constexpr auto memory_slab_alignment = _size;
+    static constexpr auto memory_segment_alignment = _segment_size;
+    static constexpr auto data_block_offset = std::size_t{ 0 };
+    static constexpr auto data_block_size = _size;
+    static constexpr auto bitmap_word_bits = elements_t::bitmap_word_bits;
+    static constexpr auto max_bitmap_elements = elements_t::max_bitmap_elements;
+
+    // Number of slabs at the beginning of the segment taken by the header table, which holds an entry for every
+    // remaining slab of the segment.
+    static constexpr auto header_table_slabs = (_segment_size / _size * sizeof(header) + _size + sizeof(header) - 1) / (_size + sizeof(header));
+    static constexpr auto slab_count = _segment_size / _size - header_table_slabs;
+
+    std::byte* data_block() {
+        return segment_base(this) + (header_table_slabs + slab_index()) * _size;
+    }
+
+    const std::byte* data_block() const {
+        return segment_base(this) + (header_table_slabs + slab_index()) * _size;
+    }
+
+    std::size_t max_elements() const {
+        return elements_t::max_elements(header.metadata);
+    }
+
+    std::size_t calculate_full_mask() const {
+        return elements_t::calculate_full_mask(header.metadata);
+    }
+
+    // Sets the element size and marks all elements as free.
+    void reset_elements(std::size_t element_size) {
+        elements_t::reset_elements(header.metadata, element_size);
+    }
+
+    bool is_empty() const {
+        return elements_t::is_empty(header.metadata);
+    }
+
+    bool is_full() const {
+        return elements_t::is_full(header.metadata);
+    }
+
+    std::size_t count_elements() const {
+        return elements_t::count_elements(header.metadata);
+    }
+
+    bool has_element(std::size_t index) const {
+        return elements_t::has_element(header.metadata, index);
+    }
+
+    std::size_t get_first_free_element() const {
+        return elements_t::get_first_free_element(header.metadata);
+    }
+
+    std::byte* get_element(std::size_t index) {
+        return elements_t::get_element(*this, index);
+    }
+
+    void set_element(std::size_t index) {
+        elements_t::set_element(header.metadata, index);
+    }
+
+    void clear_element(std::size_t index) {
+        elements_t::clear_element(header.metadata, index);
+    }
+
+    // Whether the data pages of an empty run were returned to the system (see memory_slab_elements::is_purged).
+    bool is_purged() const {
+        return elements_t::is_purged(header.metadata);
+    }
+
+    void set_purged(bool purged) {
+        elements_t::set_purged(header.metadata, purged);
+    }
+
+    std::size_t get_first_free_word() const {
+        return elements_t::get_first_free_word(header.metadata);
+    }
+
+    std::size_t get_free_elements_mask(std::size_t word_index) const {
+        return elements_t::get_free_elements_mask(header.metadata, word_index);
+    }
+
+    bool has_elements(std::size_t word_index, std::size_t elements_mask) const {
+        return elements_t::has_elements(header.metadata, word_index, elements_mask);
+    }
+
+    void set_elements(std::size_t word_index, std::size_t elements_mask) {
+        elements_t::set_elements(header.metadata, word_index, elements_mask);
+    }
+
+    void clear_elements(std::size_t word_index, std::size_t elements_mask) {
+        elements_t::clear_elements(header.metadata, word_index, elements_mask);
+    }
+
+    // Slab starting offset bytes past the beginning of this one.
+    out_of_band_slab* slab_at_offset(std::size_t offset) {
+        return this + offset / _size;
+    }
+
+    static out_of_band_slab* from_pointer(const void* const data) {
+        auto* const segment = segment_base(data);
+        const auto slab_index = static_cast<std::size_t>(static_cast<const std::byte*>(data) - segment) / _size;
+
+        assert(slab_index >= header_table_slabs && "pointer must not point into the header table");
+
+        return first_in_segment(segment) + (slab_index - header_table_slabs);
+    }
+
+    // Slab whose header (an entry of the header table) contains the given address.
+    static out_of_band_slab* from_header_address(const void* const address) {
+        auto* const segment = segment_base(address);
+        return first_in_segment(segment) + static_cast<std::size_t>(static_cast<const std::byte*>(address) - segment) / sizeof(out_of_band_slab);
+    }
+
+    // Header of the first slab of the segment starting at the given (segment aligned) address.
+    static out_of_band_slab* first_in_segment(void* const segment) {
+        assert(reinterpret_cast<std::uintptr_t>(segment) % _segment_size == 0 && "segment must be aligned to its size");
+
+        return std::launder(reinterpret_cast<out_of_band_slab*>(segment));
+    }
+
+private:
+    static std::byte* segment_base(const void* const data) {
+        return reinterpret_cast<std::byte*>(reinterpret_cast<std::uintptr_t>(data) & ~(_segment_size - 1));
+    }
+
+    std::size_t slab_index() const {
+        return static_cast<std::size_t>(this - first_in_segment(segment_base(this)));
+    }
+};
+
+static_assert(std::is_trivial_v<out_of_band_slab<256, 64 * 1024>>);
+static_assert(sizeof(out_of_band_slab<256, 64 * 1024>) == sizeof(out_of_band_slab<256, 64 * 1024>::header));
+static_assert(out_of_band_slab<256, 64 * 1024>::header_table_slabs == 46);
+static_assert(out_of_band_slab<256, 64 * 1024>::slab_count * sizeof(out_of_band_slab<256, 64 * 1024>) <= 46 * 256);
+static_assert(sizeof(out_of_band_slab<64, 64 * 1024, 1, true>) == 28);
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <cassert>
+#include <mutex>
+
+#include "memory.h"
+#include "memory_segment.h"
+#include "utils.h"
+
+namespace allocator {
+
+template <allocator _allocator_t, std::size_t _slab_size = 1024, std::size_t _segment_size = 1024 * 1024, std::size_t _segments_per_block = 4>
+class segment_pool final {
+public:
+    using segment_t = memory_segment<_segment_size, _slab_size>;
+
+    const static auto slab_size = _slab_size;
+    const static auto segment_size = _segment_size;
+
+    segment_t* acquire(void* const owner) {
+        std::lock_guard lock{ _mutex };
+
+        if (_free_segments == nullptr)
+            allocate_new_block();
+
+        auto* const segment = _free_segments;
+        _free_segments = segment->header.next;
+
+        segment->header.owner = owner;
+        segment->header.next = nullptr;
+
+        return segment;
+    }
+
+    void release(segment_t* const segment) {
+        assert(segment != nullptr && "segment must not be null");
+        assert(segment->slabs()->is_empty() && "segment must be empty when released");
+        assert(segment->slabs()->header.neighbors.next == nullptr && "segment must not be split when released");
+
+        std::lock_guard lock{ _mutex };
+
+        segment->header.owner = nullptr;
+        segment->header.previous = nullptr;
+        segment->header.next = _free_segments;
+        _free_segments = segment;
+    }
+
+private:
+    void allocate_new_block() {
+        const auto alignment_padding = block_alignment_v<_allocator_t> >= _segment_size ? 0 : _segment_size;
+        const auto allocation_size = _segments_per_block * _segment_size + alignment_padding;
+        const auto allocation_result = _allocator.allocate_at_least(allocation_size);
+        const auto block_begin = reinterpret_cast<std::uintptr_t>(allocation_result.ptr);
+        const auto block_end = block_begin + allocation_result.count;
+        const auto aligned_begin = (block_begin + _segment_size - 1) / _segment_size * _segment_size;
+
+        if (aligned_begin + _segment_size > block_end)
+            throw std::runtime_error("allocated block is too small to hold a memory segment");
+
+        for (auto segment_begin = aligned_begin; segment_begin + _segment_size <= block_end; segment_begin += _segment_size) {
+            auto* const segment = std::launder(reinterpret_cast<segment_t*>(segment_begin));
+            launder_segment(segment);
+
+            segment->header.next = _free_segments;
+            _free_segments = segment;
+        }
+    }
+
+    std::mutex _mutex;
+    _allocator_t _allocator{};
+    segment_t* _free_segments{ nullptr };
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace allocator {
+
+// Maps allocation sizes below _max_size onto a fixed set of element sizes.
+// Sizes up to min_class_spacing are rounded up to powers of two. Above that, every doubling is divided into
+// _classes_per_doubling evenly spaced classes (so 4 classes per doubling give 80, 96, 112, 128, 160, ...).
+// The spacing never drops below min_class_spacing, so every class keeps the alignment of std::max_align_t.
+template <std::size_t _max_size, std::size_t _classes_per_doubling = 1>
+struct size_classes final {
+    static_assert(std::has_single_bit(_classes_per_doubling), "Number of classes per doubling must be a power of two");
+    static_assert(_classes_per_doubling <= 16, "At most 16 classes per doubling are supported");
+
+    static constexpr std::size_t min_class_spacing = 16;
+
+    // Element index lookups multiply by a precomputed reciprocal instead of dividing. The reciprocal is exact
+    // as long as the product of the offset and the element size fits in 32 bits.
+    static constexpr bool has_reciprocals = _max_size <= (std::size_t{ 1 } << 16);
+
+    static constexpr std::size_t class_size(const std::size_t size) {
+        if (size <= min_class_spacing) {
+            return std::bit_ceil(size);
+        }
+
+        const auto spacing_shift = class_spacing_shift(std::bit_width(size - 1));
+        return (((size - 1) >> spacing_shift) + 1) << spacing_shift;
+    }
+
+    static constexpr std::size_t class_index(const std::size_t size) {
+        if (size <= min_class_spacing) {
+            return std::bit_width(size - 1);
+        }
+
+        const auto doubling = std::bit_width(size - 1);
+        const auto spacing_shift = class_spacing_shift(doubling);
+        const auto class_in_doubling = ((size - 1) >> spacing_shift) - (std::size_t{ 1 } << (doubling - 1 - spacing_shift));
+
+        return _doubling_offsets[doubling] + class_in_doubling;
+    }
+
+    static constexpr std::size_t count() {
+        return class_index(_max_size - 1) + 1;
+    }
+
+    // Returns offset / element_size. Element sizes of _max_size and above only ever host a single element.
+    static std::size_t element_index(const std::size_t offset, const std::size_t element_size) {
+        if constexpr (has_reciprocals) {
+            static constexpr auto reciprocals = make_reciprocals();
+            return (offset * reciprocals[std::min(class_index(element_size), count() - 1)]) >> 32;
+        }
+        else {
+            return offset / element_size;
+        }
+    }
+
+private:
+    static constexpr std::size_t _classes_per_doubling_shift = std::countr_zero(_classes_per_doubling);
+    static constexpr std::size_t _min_class_spacing_shift = std::countr_zero(min_class_spacing);
+    static constexpr std::size_t _pow2_classes = _min_class_spacing_shift + 1;
+
+    static constexpr std::size_t class_spacing_shift(const std::size_t doubling) {
+        return std::max(doubling - 1 - _classes_per_doubling_shift, _min_class_spacing_shift);
+    }
+
+    // Index of the first class of every doubling (sizes up to 2^doubling), indexed by the doubling. Doublings with
+    // the spacing held at min_class_spacing have fewer than _classes_per_doubling classes, so the indices stay dense.
+    static constexpr auto make_doubling_offsets() {
+        std::array<std::uint16_t, std::numeric_limits<std::size_t>::digits + 1> offsets{};
+        std::size_t offset = _pow2_classes;
+
+        for (std::size_t doubling = _pow2_classes; doubling < offsets.size(); ++doubling) {
+            offsets[doubling] = static_cast<std::uint16_t>(offset);
+            offset += std::size_t{ 1 } << (doubling - 1 - class_spacing_shift(doubling));
+        }
+
+        return offsets;
+    }
+
+    static constexpr auto _doubling_offsets = make_doubling_offsets();
+
+    static constexpr auto make_reciprocals() {
+        std::array<std::uint64_t, count()> reciprocals{};
+
+        for (std::size_t size = 1; size < _max_size; size = class_size(size) + 1) {
+            reciprocals[class_index(size)] = (std::uint64_t{ 1 } << 32) / class_size(size) + 1;
+        }
+
+        return reciprocals;
+    }
+};
+
+static_assert(size_classes<1024>::class_size(33) == 64);
+static_assert(size_classes<1024>::class_index(33) == 6);
+static_assert(size_classes<1024, 4>::class_size(33) == 48);
+static_assert(size_classes<1024, 4>::class_size(65) == 80);
+static_assert(size_classes<1024, 4>::class_size(7) == 8);
+static_assert(size_classes<1024, 4>::class_index(48) == 6);
+static_assert(size_classes<1024, 4>::class_index(80) == 8);
+
+}
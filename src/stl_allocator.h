@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <type_traits>
+
+namespace allocator {
+
+// Stateful, standard-library-compatible allocator bound to an instance of one of the allocators of this
+// library (memory, free_memory_manager or thread_cache). The allocator does not own the bound instance,
+// and two allocators compare equal if they are bound to the same one.
+template <typename T, typename _memory_t>
+class stl_allocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    template <typename U>
+    struct rebind {
+        using other = stl_allocator<U, _memory_t>;
+    };
+
+    explicit stl_allocator(_memory_t& memory) noexcept : _memory{ &memory } {}
+
+    template <typename U>
+    stl_allocator(const stl_allocator<U, _memory_t>& other) noexcept : _memory{ other._memory } {}
+
+    T* allocate(std::size_t count) {
+        if (count > std::numeric_limits<std::size_t>::max() / sizeof(T))
+            throw std::bad_array_new_length();
+
+        auto* const data = _memory->allocate(count * sizeof(T), alignof(T));
+
+        if (!data)
+            throw std::bad_alloc();
+
+        return static_cast<T*>(data);
+    }
+
+    void deallocate(T* const data, std::size_t) {
+        _memory->deallocate(static_cast<void*>(data));
+    }
+
+    _memory_t& memory() const noexcept {
+        return *_memory;
+    }
+
+    template <typename U>
+    bool operator==(const stl_allocator<U, _memory_t>& other) const noexcept {
+        return _memory == other._memory;
+    }
+
+private:
+    _memory_t* _memory;
+
+    template <typename, typename>
+    friend class stl_allocator;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cassert>
+
+#include "free_memory_manager.h"
+#include "memory_segment.h"
+
+namespace allocator {
+
+// Per-thread front-end over a shared segment_pool. Every thread owns its own free_memory_manager
+// (and so its own buckets), and only takes the pool lock to acquire fresh segments or to hand back
+// segments that became fully empty. Memory released by a thread other than the owner of its segment
+// is pushed onto the owner's lock-free remote-free list and reclaimed by the owner in batches, so slab
+// masks are only ever modified by the owning thread. A thread_cache must outlive every allocation it served.
+template <typename _segment_pool_t, std::size_t _retained_segments = 1>
+class thread_cache final {
+public:
+    using segment_t = typename _segment_pool_t::segment_t;
+
+    explicit thread_cache(_segment_pool_t& segment_pool) : _segment_pool{ segment_pool } {}
+
+    thread_cache(const thread_cache&) = delete;
+    thread_cache& operator=(const thread_cache&) = delete;
+
+    ~thread_cache() {
+        drain_remote_frees();
+
+        auto* segment = _segments;
+
+        while (segment != nullptr) {
+            auto* const next = segment->header.next;
+
+            if (is_segment_empty(segment))
+                release_segment(segment);
+
+            segment = next;
+        }
+    }
+
+    void* allocate(std::size_t size) {
+        size = std::max(size, sizeof(remote_free_node));
+
+        if (_remote_frees.load(std::memory_order_relaxed) != nullptr)
+            drain_remote_frees();
+
+        auto* const data = _free_memory_manager.allocate(size);
+
+        if (data || !fits_in_segment(_free_memory_manager.required_segment_size(size)))
+            return data;
+
+        acquire_segment();
+
+        return _free_memory_manager.allocate(size);
+    }
+
+    void* allocate(std::size_t size, std::size_t alignment) {
+        size = std::max(size, sizeof(remote_free_node));
+
+        if (_remote_frees.load(std::memory_order_relaxed) != nullptr)
+            drain_remote_frees();
+
+        auto* const data = _free_memory_manager.allocate(size, alignment);
+
+        if (data || alignment > free_memory_manager<_segment_pool_t::slab_size>::max_alignment)
+            return data;
+
+        if (!fits_in_segment(_free_memory_manager.required_segment_size(size, alignment)))
+            return nullptr;
+
+        acquire_segment();
+
+        return _free_memory_manager.allocate(size, alignment);
+    }
+
+    void deallocate(void* const data) {
+        auto* const segment = segment_t::from_pointer(data);
+        auto* const owner = static_cast<thread_cache*>(segment->header.owner);
+
+        assert(owner != nullptr && "data must belong to a segment owned by a thread cache");
+
+        if (owner != this) {
+            owner->push_remote_free(data);
+            return;
+        }
+
+        deallocate_local(segment, data);
+    }
+
+private:
+    struct remote_free_node {
+        remote_free_node* next;
+    };
+
+    void deallocate_local(segment_t* const segment, void* const data) {
+        assert(segment->header.owner == this && "data must be owned by this thread cache");
+
+        _free_memory_manager.deallocate(data);
+
+        if (_segment_count > _retained_segments && is_segment_empty(segment))
+            release_segment(segment);
+    }
+
+    void push_remote_free(void* const data) {
+        auto* const node = new (data) remote_free_node{ _remote_frees.load(std::memory_order_relaxed) };
+
+        while (!_remote_frees.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    void drain_remote_frees() {
+        auto* node = _remote_frees.exchange(nullptr, std::memory_order_acquire);
+
+        while (node != nullptr) {
+            auto* const next = node->next;
+            deallocate_local(segment_t::from_pointer(node), node);
+            node = next;
+        }
+    }
+
+    // Requests that do not fit into the slabs of a single segment would leave every acquired segment empty.
+    static bool fits_in_segment(const std::size_t required_size) {
+        return required_size <= segment_t::slab_count * _segment_pool_t::slab_size;
+    }
+
+    void acquire_segment() {
+        auto* const segment = _segment_pool.acquire(this);
+
+        segment->header.previous = nullptr;
+        segment->header.next = _segments;
+
+        if (_segments != nullptr)
+            _segments->header.previous = segment;
+
+        _segments = segment;
+        ++_segment_count;
+
+        _free_memory_manager.add_new_memory_segment(segment->slabs());
+    }
+
+    void release_segment(segment_t* const segment) {
+        assert(is_segment_empty(segment) && "segment must be empty when released");
+
+        _free_memory_manager.remove_memory_segment(segment->slabs());
+
+        if (segment->header.previous != nullptr)
+            segment->header.previous->header.next = segment->header.next;
+        else
+            _segments = segment->header.next;
+
+        if (segment->header.next != nullptr)
+            segment->header.next->header.previous = segment->header.previous;
+
+        --_segment_count;
+
+        _segment_pool.release(segment);
+    }
+
+    static bool is_segment_empty(segment_t* const segment) {
+        auto* const slab = segment->slabs();
+        return slab->is_empty() && slab->header.neighbors.next == nullptr;
+    }
+
+    _segment_pool_t& _segment_pool;
+    free_memory_manager<_segment_pool_t::slab_size> _free_memory_manager{};
+    segment_t* _segments{ nullptr };
+    std::size_t _segment_count{ 0 };
+
+    alignas(64) std::atomic<remote_free_node*> _remote_frees{ nullptr };
+
+    friend class ThreadCacheTest;
+};
+
+}
\ No newline at end of file
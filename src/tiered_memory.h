@@ -0,0 +1,253 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <tuple>
+#include <utility>
+
+#include "free_memory_manager.h"
+#include "memory_segment.h"
+#include "utils.h"
+
+namespace allocator {
+
+// Single-threaded front-end combining free_memory_managers of several slab sizes (tiers, in increasing order),
+// all of them taking their segments from one shared segment_pool. Every request is routed by its size to the
+// first tier whose slabs fit at least two elements of its size class (larger requests go to the last tier),
+// using a constexpr table indexed by the bit width of the size. Segments are re-laundered with the slabs of the
+// tier that acquired them, and the owner field of the segment header points to that tier, so deallocate finds
+// the tier from the pointer alone. Every tier retains one empty segment and hands the others back to the pool,
+// where any tier can pick them up. A tiered_memory must outlive all allocations it served.
+template <typename _segment_pool_t, std::size_t... _slab_sizes>
+class tiered_memory final {
+public:
+    static constexpr auto segment_size = _segment_pool_t::segment_size;
+    static constexpr auto tier_count = sizeof...(_slab_sizes);
+    static constexpr std::array<std::size_t, tier_count> slab_sizes{ _slab_sizes... };
+
+    static_assert(tier_count >= 1, "tiered_memory requires at least one tier");
+    static_assert(std::is_sorted(slab_sizes.begin(), slab_sizes.end()), "Tier slab sizes must be in increasing order");
+
+    explicit tiered_memory(_segment_pool_t& segment_pool) : _segment_pool{ segment_pool } {}
+
+    tiered_memory(const tiered_memory&) = delete;
+    tiered_memory& operator=(const tiered_memory&) = delete;
+
+    ~tiered_memory() {
+        for_each_tier([&]<std::size_t _tier>() {
+            auto& tier = std::get<_tier>(_tiers);
+            auto* segment = tier.segments;
+
+            while (segment != nullptr) {
+                auto* const next = segment->header.next;
+
+                if (is_segment_empty(segment))
+                    release_segment<_tier>(segment);
+
+                segment = next;
+            }
+        });
+    }
+
+    // Index of the tier serving requests of the given size.
+    static constexpr std::size_t tier_index(const std::size_t size) {
+        return _tiers_by_size_width[std::bit_width(size - (size != 0))];
+    }
+
+    void* allocate(const std::size_t size) {
+        return allocate_from_tier(tier_index(size), size, natural_alignment);
+    }
+
+    // Allocates size bytes aligned to the given power of two, in the tier of the size or in the first tier with
+    // slabs large enough for the alignment. Returns nullptr for alignments that no tier supports.
+    void* allocate(const std::size_t size, const std::size_t alignment) {
+        const auto index = std::max(tier_index(size), alignment_tier_index(alignment));
+
+        return index < tier_count ? allocate_from_tier(index, size, alignment) : nullptr;
+    }
+
+    void deallocate(void* const data) {
+        if (!data)
+            return;
+
+        auto* const owner = _segment_pool_t::segment_t::from_pointer(data)->header.owner;
+        [[maybe_unused]] bool released = false;
+
+        for_each_tier([&]<std::size_t _tier>() {
+            if (owner == &std::get<_tier>(_tiers)) {
+                deallocate_in_tier<_tier>(data);
+                released = true;
+            }
+        });
+
+        assert(released && "data must belong to a segment owned by a tier of this tiered_memory");
+    }
+
+    // Number of segments currently held by the tier.
+    std::size_t segment_count(const std::size_t tier_index) const {
+        std::size_t count = 0;
+
+        for_each_tier([&]<std::size_t _tier>() {
+            if (tier_index == _tier)
+                count = std::get<_tier>(_tiers).segment_count;
+        });
+
+        return count;
+    }
+
+private:
+    static constexpr std::size_t natural_alignment = alignof(std::max_align_t);
+
+    template <std::size_t _slab_size>
+    struct tier final {
+        using segment_t = memory_segment<segment_size, _slab_size>;
+        using manager_t = free_memory_manager<_slab_size>;
+
+        manager_t manager{};
+        segment_t* segments{ nullptr };
+        std::size_t segment_count{ 0 };
+    };
+
+    using tiers_t = std::tuple<tier<_slab_sizes>...>;
+
+    template <std::size_t _tier>
+    using tier_t = std::tuple_element_t<_tier, tiers_t>;
+
+    template <typename _function_t>
+    static void for_each_tier(_function_t&& function) {
+        [&]<std::size_t... _tier>(std::index_sequence<_tier...>) {
+            (function.template operator()<_tier>(), ...);
+        }(std::make_index_sequence<tier_count>{});
+    }
+
+    // Tier of every size with the given bit width (sizes up to 2^width), indexed by the width.
+    static constexpr auto make_tiers_by_size_width() {
+        constexpr std::array<std::size_t, tier_count> data_block_sizes{ memory_slab<_slab_sizes>::data_block_size... };
+        std::array<std::uint8_t, std::numeric_limits<std::size_t>::digits + 1> tiers{};
+
+        for (std::size_t width = 0; width < tiers.size(); ++width) {
+            const auto tier = std::find_if(data_block_sizes.begin(), data_block_sizes.end(), [&](const std::size_t data_block_size) {
+                return width < std::numeric_limits<std::size_t>::digits && std::size_t{ 1 } << width <= data_block_size / 2;
+            });
+
+            tiers[width] = static_cast<std::uint8_t>(std::min<std::size_t>(tier - data_block_sizes.begin(), tier_count - 1));
+        }
+
+        return tiers;
+    }
+
+    static constexpr auto _tiers_by_size_width = make_tiers_by_size_width();
+
+    static std::size_t alignment_tier_index(const std::size_t alignment) {
+        constexpr std::array<std::size_t, tier_count> max_alignments{ free_memory_manager<_slab_sizes>::max_alignment... };
+
+        return std::find_if(max_alignments.begin(), max_alignments.end(), [&](const std::size_t max_alignment) {
+            return alignment <= max_alignment;
+        }) - max_alignments.begin();
+    }
+
+    void* allocate_from_tier(const std::size_t index, const std::size_t size, const std::size_t alignment) {
+        void* data = nullptr;
+
+        for_each_tier([&]<std::size_t _tier>() {
+            if (index == _tier)
+                data = allocate_in_tier<_tier>(size, alignment);
+        });
+
+        return data;
+    }
+
+    template <std::size_t _tier>
+    void* allocate_in_tier(const std::size_t size, const std::size_t alignment) {
+        auto& manager = std::get<_tier>(_tiers).manager;
+        const auto allocate = [&] {
+            return alignment > natural_alignment ? manager.allocate(size, alignment) : manager.allocate(size);
+        };
+
+        if (auto* const data = allocate())
+            return data;
+
+        const auto required_size = alignment > natural_alignment
+            ? manager.required_segment_size(size, alignment)
+            : manager.required_segment_size(size);
+
+        if (required_size > tier_t<_tier>::segment_t::slab_count * slab_sizes[_tier])
+            return nullptr;
+
+        acquire_segment<_tier>();
+
+        return allocate();
+    }
+
+    template <std::size_t _tier>
+    void deallocate_in_tier(void* const data) {
+        auto& tier = std::get<_tier>(_tiers);
+        auto* const segment = tier_t<_tier>::segment_t::from_pointer(data);
+
+        tier.manager.deallocate(data);
+
+        if (tier.segment_count > 1 && is_segment_empty(segment))
+            release_segment<_tier>(segment);
+    }
+
+    template <std::size_t _tier>
+    void acquire_segment() {
+        auto& tier = std::get<_tier>(_tiers);
+        auto* const segment = std::launder(reinterpret_cast<typename tier_t<_tier>::segment_t*>(_segment_pool.acquire(&tier)));
+
+        launder_segment(segment);
+
+        segment->header.owner = &tier;
+        segment->header.next = tier.segments;
+
+        if (tier.segments != nullptr)
+            tier.segments->header.previous = segment;
+
+        tier.segments = segment;
+        ++tier.segment_count;
+
+        tier.manager.add_new_memory_segment(segment->slabs());
+    }
+
+    // Hands the segment back to the pool, re-laundered with the slabs of the pool.
+    template <std::size_t _tier>
+    void release_segment(typename tier_t<_tier>::segment_t* const segment) {
+        auto& tier = std::get<_tier>(_tiers);
+
+        assert(is_segment_empty(segment) && "segment must be empty when released");
+
+        tier.manager.remove_memory_segment(segment->slabs());
+
+        if (segment->header.previous != nullptr)
+            segment->header.previous->header.next = segment->header.next;
+        else
+            tier.segments = segment->header.next;
+
+        if (segment->header.next != nullptr)
+            segment->header.next->header.previous = segment->header.previous;
+
+        --tier.segment_count;
+
+        auto* const pool_segment = std::launder(reinterpret_cast<typename _segment_pool_t::segment_t*>(segment));
+        launder_segment(pool_segment);
+
+        _segment_pool.release(pool_segment);
+    }
+
+    template <typename _segment_t>
+    static bool is_segment_empty(_segment_t* const segment) {
+        auto* const slab = segment->slabs();
+        return slab->is_empty() && slab->header.neighbors.next == nullptr;
+    }
+
+    _segment_pool_t& _segment_pool;
+    tiers_t _tiers{};
+};
+
+}
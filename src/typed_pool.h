@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace allocator {
+
+// Pool of objects of a single type, carving whole slabs taken from a memory or free_memory_manager instance
+// (shared with its general allocations) into elements of sizeof(T) bytes. The element size, the number of
+// elements per slab and the mask of a full slab are all known at compile time, so allocations skip the size
+// class lookup of the manager, and releases find the element index without loading the element size of the
+// slab. Slabs with free elements are kept in a list linked through their (otherwise unused) free_list
+// headers. A slab that becomes empty is kept as a spare (if there is none yet) or handed back to the
+// underlying allocator. Memory served by the pool must be released to the pool, which must outlive it.
+template <typename T, typename _memory_t>
+class typed_pool final {
+public:
+    using slab_t = typename _memory_t::slab_t;
+
+    static constexpr std::size_t element_size = sizeof(T);
+    static constexpr std::size_t slab_capacity = std::min(slab_t::data_block_size / element_size, 0 + slab_t::max_bitmap_elements);
+    // Value of the bitmap of a full slab with a single bitmap word.
+    static constexpr std::size_t full_mask = slab_capacity >= std::numeric_limits<std::size_t>::digits ? ~std::size_t{ 0 } : (std::size_t{ 1 } << slab_capacity) - 1;
+
+    static_assert(element_size < slab_t::data_block_size, "typed_pool elements must be smaller than the data block of a slab");
+    static_assert(alignof(T) <= alignof(std::max_align_t), "alignment of T exceeds the alignment of slab data blocks");
+
+    explicit typed_pool(_memory_t& memory) : _memory{ memory } {}
+
+    typed_pool(const typed_pool&) = delete;
+    typed_pool& operator=(const typed_pool&) = delete;
+
+    ~typed_pool() {
+        if (_spare_slab != nullptr)
+            _memory.deallocate(static_cast<void*>(_spare_slab->data_block()));
+    }
+
+    // Returns uninitialized memory for a single T, or nullptr if the underlying allocator ran out of memory.
+    void* allocate() {
+        if (_slabs == nullptr && !add_slab())
+            return nullptr;
+
+        auto* const slab = _slabs;
+        const auto element_index = slab->get_first_free_element();
+
+        assert(element_index < slab_capacity && "element index must be within slab bounds");
+
+        slab->set_element(element_index);
+
+        if (is_full(slab))
+            unlink_slab(slab);
+
+        return slab->data_block() + element_index * element_size;
+    }
+
+    void deallocate(void* const data) {
+        auto* const slab = slab_t::from_pointer(data);
+        const auto element_index = static_cast<std::size_t>(static_cast<std::byte*>(data) - slab->data_block()) / element_size;
+        const auto was_full = is_full(slab);
+
+        assert(slab->header.metadata.element_size == element_size && "data must be allocated by a typed_pool of the same type");
+        assert(slab->has_element(element_index) && "element must exist in slab before release");
+
+        slab->clear_element(element_index);
+
+        if (was_full)
+            push_slab(slab);
+
+        if (slab->is_empty())
+            release_slab(slab);
+    }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        auto* const data = allocate();
+
+        return data ? new (data) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    void destroy(const T* const data) {
+        if (!data)
+            return;
+
+        data->~T();
+
+        deallocate(const_cast<T*>(data));
+    }
+
+private:
+    // Takes the spare slab, or a single slab allocated from the underlying allocator (as a large allocation of
+    // exactly one data block), and divides it into elements.
+    bool add_slab() {
+        auto* slab = std::exchange(_spare_slab, nullptr);
+
+        if (slab == nullptr) {
+            auto* const data = _memory.allocate(slab_t::data_block_size);
+
+            if (data == nullptr)
+                return false;
+
+            slab = slab_t::from_pointer(data);
+
+            assert(data == slab->data_block() && "large allocations must start at the data block of their slab");
+        }
+
+        slab->reset_elements(element_size);
+        push_slab(slab);
+
+        return true;
+    }
+
+    // Turns the empty slab back into a single-slab large allocation (so that the underlying allocator never
+    // sees it as free memory), and keeps it as the spare or releases it.
+    void release_slab(slab_t* const slab) {
+        unlink_slab(slab);
+
+        slab->reset_elements(slab_t::data_block_size);
+        slab->set_element(0);
+
+        if (_spare_slab == nullptr)
+            _spare_slab = slab;
+        else
+            _memory.deallocate(static_cast<void*>(slab->data_block()));
+    }
+
+    static bool is_full(const slab_t* const slab) {
+        if constexpr (slab_t::max_bitmap_elements == slab_t::bitmap_word_bits)
+            return slab->header.metadata.mask == full_mask;
+        else
+            return slab->is_full();
+    }
+
+    void push_slab(slab_t* const slab) {
+        slab->header.free_list.previous = nullptr;
+        slab->header.free_list.next = _slabs;
+
+        if (_slabs != nullptr)
+            _slabs->header.free_list.previous = slab;
+
+        _slabs = slab;
+    }
+
+    void unlink_slab(slab_t* const slab) {
+        slab_t* const previous = slab->header.free_list.previous;
+        slab_t* const next = slab->header.free_list.next;
+
+        if (previous != nullptr)
+            previous->header.free_list.next = next;
+        else
+            _slabs = next;
+
+        if (next != nullptr)
+            next->header.free_list.previous = previous;
+
+        slab->header.free_list.previous = nullptr;
+        slab->header.free_list.next = nullptr;
+    }
+
+    _memory_t& _memory;
+    slab_t* _slabs{ nullptr };
+    slab_t* _spare_slab{ nullptr };
+};
+
+}
@@ -1,19 +1,38 @@
 #pragma once
 
+#include "memory_segment.h"
 #include "memory_slab.h"
+#include "out_of_band_slab.h"
 
 namespace allocator {
 
-template <std::size_t _slab_size>
-void launder_slab(memory_slab<_slab_size>* slab, const std::size_t slab_count) {
+template <typename _slab_t>
+void launder_slab(_slab_t* slab, const std::size_t slab_count) {
     auto* aligned_slab = std::launder(slab);
-    aligned_slab->header.metadata.mask = 0;
-    aligned_slab->header.metadata.full_mask = 1;
-    aligned_slab->header.metadata.element_size = slab_count * _slab_size - memory_slab<_slab_size>::data_block_offset;
+    aligned_slab->reset_elements(slab_count * _slab_t::memory_slab_alignment - _slab_t::data_block_offset);
     aligned_slab->header.neighbors.previous = nullptr;
     aligned_slab->header.neighbors.next = nullptr;
     aligned_slab->header.free_list.previous = nullptr;
     aligned_slab->header.free_list.next = nullptr;
 }
 
+template <std::size_t _segment_size, std::size_t _slab_size>
+void launder_segment(memory_segment<_segment_size, _slab_size>* segment) {
+    auto* aligned_segment = std::launder(segment);
+    aligned_segment->header.owner = nullptr;
+    aligned_segment->header.previous = nullptr;
+    aligned_segment->header.next = nullptr;
+    launder_slab(aligned_segment->slabs(), memory_segment<_segment_size, _slab_size>::slab_count);
+}
+
+// Initializes the header table of a memory segment of out of band slabs (see out_of_band_slab), describing all of
+// its slabs as a single empty run, and returns the first slab.
+template <typename _slab_t>
+_slab_t* launder_header_table(void* const segment) {
+    auto* const slab = _slab_t::first_in_segment(segment);
+    launder_slab(slab, _slab_t::slab_count);
+
+    return slab;
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "src/allocation_trace.h"
+#include "src/memory.h"
+#include <gtest/gtest.h>
+#include <sstream>
+
+namespace allocator {
+
+TEST(AllocationTraceTests, RecordsAllocationsAndReleases) {
+    in_place_memory memory;
+    traced_memory traced{ memory };
+
+    void* ptr1 = traced.allocate(16);
+    void* ptr2 = traced.allocate(100);
+    traced.deallocate(ptr1);
+    void* ptr3 = traced.allocate(16);
+    traced.deallocate(ptr2);
+    traced.deallocate(ptr3);
+
+    const auto events = traced.recorder().events();
+
+    ASSERT_EQ(events.size(), 6);
+
+    ASSERT_EQ(events[0].operation, trace_operation::allocate);
+    ASSERT_EQ(events[0].pointer_id, 0);
+    ASSERT_EQ(events[0].size, 16);
+    ASSERT_EQ(events[1].pointer_id, 1);
+    ASSERT_EQ(events[1].size, 100);
+    ASSERT_EQ(events[2].operation, trace_operation::deallocate);
+    ASSERT_EQ(events[2].pointer_id, 0);
+
+    // The address of the first allocation is reused, but the new allocation gets a new id.
+    ASSERT_EQ(ptr3, ptr1);
+    ASSERT_EQ(events[3].pointer_id, 2);
+    ASSERT_EQ(events[4].pointer_id, 1);
+    ASSERT_EQ(events[5].pointer_id, 2);
+
+    ASSERT_LE(events[0].timestamp, events[5].timestamp);
+}
+
+TEST(AllocationTraceTests, OverwritesOldestEntries) {
+    trace_recorder<4> recorder;
+    int objects[3];
+
+    recorder.record(trace_operation::allocate, &objects[0], 8);
+    recorder.record(trace_operation::allocate, &objects[1], 8);
+    recorder.record(trace_operation::allocate, &objects[2], 8);
+    recorder.record(trace_operation::deallocate, &objects[1]);
+    recorder.record(trace_operation::deallocate, &objects[0]);
+
+    ASSERT_EQ(recorder.recorded(), 5);
+    ASSERT_EQ(recorder.size(), 4);
+
+    // The allocation of objects[0] was overwritten, so its release is dropped as well.
+    const auto events = recorder.events();
+
+    ASSERT_EQ(events.size(), 3);
+    ASSERT_EQ(events[0].pointer_id, 0);
+    ASSERT_EQ(events[1].pointer_id, 1);
+    ASSERT_EQ(events[2].operation, trace_operation::deallocate);
+    ASSERT_EQ(events[2].pointer_id, 0);
+}
+
+TEST(AllocationTraceTests, SavesAndLoadsTrace) {
+    trace_recorder<16> recorder;
+    int objects[2];
+
+    recorder.record(trace_operation::allocate, &objects[0], 24);
+    recorder.record(trace_operation::allocate, &objects[1], 4096);
+    recorder.record(trace_operation::deallocate, &objects[0]);
+
+    std::stringstream stream;
+    recorder.save(stream);
+
+    const auto events = load_trace(stream);
+    const auto recorded_events = recorder.events();
+
+    ASSERT_EQ(events.size(), 3);
+
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        ASSERT_EQ(events[i].timestamp, recorded_events[i].timestamp);
+        ASSERT_EQ(events[i].pointer_id, recorded_events[i].pointer_id);
+        ASSERT_EQ(events[i].size, recorded_events[i].size);
+        ASSERT_EQ(events[i].operation, recorded_events[i].operation);
+    }
+}
+
+TEST(AllocationTraceTests, SavesSizesAbove4GiB) {
+    trace_recorder<4> recorder;
+    int object;
+
+    recorder.record(trace_operation::allocate, &object, (std::size_t{ 1 } << 32) + 16);
+    recorder.record(trace_operation::allocate, &object + 1, std::size_t{ 3 } << 30);
+    recorder.record(trace_operation::deallocate, &object);
+
+    std::stringstream stream;
+    recorder.save(stream);
+
+    const auto events = load_trace(stream);
+
+    ASSERT_EQ(events.size(), 3);
+    ASSERT_EQ(events[0].size, (std::uint64_t{ 1 } << 32) + 16);
+    ASSERT_EQ(events[0].operation, trace_operation::allocate);
+    ASSERT_EQ(events[1].size, std::uint64_t{ 3 } << 30);
+    ASSERT_EQ(events[1].operation, trace_operation::allocate);
+    ASSERT_EQ(events[2].operation, trace_operation::deallocate);
+}
+
+TEST(AllocationTraceTests, DoesNotRecordNullReleases) {
+    in_place_memory memory;
+    traced_memory traced{ memory };
+
+    traced.deallocate(nullptr);
+
+    ASSERT_EQ(traced.recorder().recorded(), 0);
+}
+
+TEST(AllocationTraceTests, RejectsInvalidTrace) {
+    std::stringstream stream{ "not a trace" };
+
+    ASSERT_THROW(load_trace(stream), std::runtime_error);
+}
+
+}
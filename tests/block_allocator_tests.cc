@@ -0,0 +1,119 @@
+#include "src/block_allocator.h"
+#include "src/memory.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+namespace allocator {
+
+using test_mmap_block_allocator = mmap_block_allocator<64 * 1024 * 1024, 1024 * 1024, 64 * 1024>;
+
+TEST(MmapBlockAllocatorTest, AllocatesAlignedWritableBlock) {
+    test_mmap_block_allocator block_allocator;
+
+    const auto result = block_allocator.allocate_at_least(100);
+
+    ASSERT_NE(result.ptr, nullptr);
+    ASSERT_EQ(result.count, 1024 * 1024);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(result.ptr) % (64 * 1024), 0);
+
+    std::memset(result.ptr, 0xab, result.count);
+    ASSERT_EQ(result.ptr[result.count - 1], std::byte{ 0xab });
+}
+
+TEST(MmapBlockAllocatorTest, AllocatesConsecutiveBlocks) {
+    test_mmap_block_allocator block_allocator;
+
+    const auto result1 = block_allocator.allocate_at_least(1024 * 1024);
+    const auto result2 = block_allocator.allocate_at_least(1024 * 1024 + 1);
+
+    ASSERT_EQ(result2.ptr, result1.ptr + result1.count);
+    ASSERT_EQ(result2.count, 2 * 1024 * 1024);
+}
+
+TEST(MmapBlockAllocatorTest, ThrowsWhenReservationIsExhausted) {
+    test_mmap_block_allocator block_allocator;
+
+    block_allocator.allocate_at_least(60 * 1024 * 1024);
+
+    ASSERT_THROW(block_allocator.allocate_at_least(8 * 1024 * 1024), std::runtime_error);
+}
+
+TEST(MmapBlockAllocatorTest, ReleasesMostRecentBlock) {
+    test_mmap_block_allocator block_allocator;
+
+    const auto result1 = block_allocator.allocate_at_least(1);
+    const auto result2 = block_allocator.allocate_at_least(1);
+    block_allocator.deallocate(result2.ptr);
+    const auto result3 = block_allocator.allocate_at_least(1);
+
+    ASSERT_THROW(block_allocator.deallocate(result1.ptr), std::runtime_error);
+    ASSERT_EQ(result3.ptr, result2.ptr);
+}
+
+TEST(MmapBlockAllocatorTest, GrowsMemoryBeyondSingleBlock) {
+    memory<test_mmap_block_allocator, 1024> memory;
+    std::vector<std::array<std::byte, 512>*> values;
+
+    for (std::size_t i = 0; i < 10000; ++i) {
+        auto* const value = memory.allocate<std::array<std::byte, 512>>();
+        ASSERT_NE(value, nullptr);
+        values.push_back(value);
+    }
+
+    for (auto* value : values) {
+        memory.deallocate(value);
+    }
+}
+
+TEST(MmapBlockAllocatorTest, AllocatesObjectLargerThanCommitSize) {
+    memory<test_mmap_block_allocator, 1024> memory;
+
+    auto* const value = memory.allocate(3 * 1024 * 1024);
+
+    ASSERT_NE(value, nullptr);
+    std::memset(value, 0xab, 3 * 1024 * 1024);
+}
+
+TEST(HugePageBlockAllocatorTest, AllocatesHugePageAlignedBlocks) {
+    huge_page_block_allocator<64 * 1024 * 1024> block_allocator;
+
+    const auto result1 = block_allocator.allocate_at_least(100);
+    const auto result2 = block_allocator.allocate_at_least(3 * 1024 * 1024);
+
+    ASSERT_EQ(result1.count, os::huge_page_size);
+    ASSERT_EQ(result2.count, 2 * os::huge_page_size);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(result1.ptr) % os::huge_page_size, 0);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(result2.ptr) % os::huge_page_size, 0);
+
+    std::memset(result1.ptr, 0xab, result1.count);
+    std::memset(result2.ptr, 0xcd, result2.count);
+    ASSERT_EQ(result1.ptr[result1.count - 1], std::byte{ 0xab });
+    ASSERT_EQ(result2.ptr[result2.count - 1], std::byte{ 0xcd });
+}
+
+TEST(HugePageBlockAllocatorTest, ReleasesBlocks) {
+    huge_page_block_allocator<64 * 1024 * 1024> block_allocator;
+
+    const auto result1 = block_allocator.allocate_at_least(1);
+    block_allocator.deallocate(result1.ptr);
+    const auto result2 = block_allocator.allocate_at_least(1);
+
+    ASSERT_NE(result2.ptr, nullptr);
+}
+
+TEST(HugePageBlockAllocatorTest, BacksGrowingMemory) {
+    huge_page_memory<1024> memory;
+    std::vector<std::array<std::byte, 64>*> values;
+
+    for (std::size_t i = 0; i < 100000; ++i) {
+        values.push_back(memory.allocate<std::array<std::byte, 64>>());
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(values.back()) % 64, 0);
+    }
+
+    for (auto* value : values) {
+        memory.deallocate(value);
+    }
+}
+
+}
\ No newline at end of file
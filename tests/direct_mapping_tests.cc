@@ -0,0 +1,86 @@
+#include "src/direct_mapping.h"
+#include "src/memory_slab.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace allocator {
+
+TEST(DirectMappingTest, MapsRegionsOfWholePages) {
+    direct_mappings<memory_slab<1024>> mappings;
+
+    auto* const data = mappings.allocate(100000);
+    auto* const slab = memory_slab<1024>::from_pointer(data);
+
+    ASSERT_EQ(data, slab->data_block());
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(slab) % os::page_size(), 0);
+    ASSERT_EQ(direct_mappings<memory_slab<1024>>::region_size(slab) % os::page_size(), 0);
+    ASSERT_GE(direct_mappings<memory_slab<1024>>::region_size(slab), 100000 + memory_slab<1024>::data_block_offset);
+    ASSERT_TRUE(slab->has_element(0));
+    ASSERT_EQ(slab->header.neighbors.previous, nullptr);
+    ASSERT_EQ(slab->header.neighbors.next, nullptr);
+
+    std::memset(data, 0xff, slab->header.metadata.element_size);
+
+    mappings.deallocate(slab);
+}
+
+TEST(DirectMappingTest, AlignsRegionsToSlabSize) {
+    direct_mappings<memory_slab<64 * 1024>> mappings;
+
+    for (std::size_t i = 0; i < 4; ++i) {
+        auto* const data = mappings.allocate(200000);
+
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(data) % (64 * 1024), 0 + memory_slab<64 * 1024>::data_block_offset);
+    }
+}
+
+TEST(DirectMappingTest, ReusesCachedRegions) {
+    direct_mappings<memory_slab<1024>> mappings;
+
+    auto* const data = mappings.allocate(100000);
+
+    mappings.deallocate(memory_slab<1024>::from_pointer(data));
+
+    ASSERT_EQ(mappings.cached_count(), 1);
+    ASSERT_NE(mappings.allocate(10000), data);
+    ASSERT_EQ(mappings.allocate(90000), data);
+    ASSERT_EQ(mappings.cached_count(), 0);
+}
+
+TEST(DirectMappingTest, EvictsOldestCachedRegion) {
+    direct_mappings<memory_slab<1024>, 2> mappings;
+
+    auto* const first = mappings.allocate(100 * 1024);
+    auto* const second = mappings.allocate(200 * 1024);
+    auto* const third = mappings.allocate(300 * 1024);
+
+    mappings.deallocate(memory_slab<1024>::from_pointer(first));
+    mappings.deallocate(memory_slab<1024>::from_pointer(second));
+    mappings.deallocate(memory_slab<1024>::from_pointer(third));
+
+    ASSERT_EQ(mappings.cached_count(), 2);
+    ASSERT_EQ(mappings.allocate(300 * 1024), third);
+    ASSERT_EQ(mappings.allocate(200 * 1024), second);
+}
+
+TEST(DirectMappingTest, WalksAllocatedRegions) {
+    direct_mappings<memory_slab<1024>> mappings;
+
+    auto* const first = mappings.allocate(100000);
+    auto* const second = mappings.allocate(100000);
+    auto* const third = mappings.allocate(100000);
+
+    mappings.deallocate(memory_slab<1024>::from_pointer(second));
+
+    std::vector<const std::byte*> regions;
+
+    mappings.for_each_region([&](const memory_slab<1024>* const slab) {
+        regions.push_back(slab->data_block());
+    });
+
+    ASSERT_EQ(regions, (std::vector<const std::byte*>{ third, first }));
+}
+
+}
@@ -1,32 +1,63 @@
+#include "src/block_allocator.h"
 #include "src/free_memory_manager.h"
 #include "src/memory_slab.h"
 #include "src/utils.h"
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cstdint>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <random>
 #include <vector>
 #include <set>
+#include <thread>
 
 namespace allocator {
 
 class FreeMemoryManagerTest : public ::testing::Test {
 protected:
-    template <std::size_t _slab_size, typename... _sizes>
-    void ASSERT_MASK_EQ(const free_memory_manager<_slab_size>& manager, _sizes... sizes) {
-        ASSERT_EQ(manager._free_segments_mask, ((1ull << manager.block_size_to_bucket_index(sizes)) | ... | 0));
+    template <std::size_t _slab_size, free_memory_manager_options _options>
+    bool IS_SIZE_CLASS(const free_memory_manager<_slab_size, _options>&, std::size_t size) {
+        return size < free_memory_manager<_slab_size, _options>::slab_t::data_block_size;
     }
 
-    template <std::size_t _slab_size>
-    void ASSERT_BUCKET_EQ(const free_memory_manager<_slab_size>& manager, std::size_t size, const memory_slab<_slab_size>* slab) {
-        ASSERT_EQ(manager._free_segments[manager.block_size_to_bucket_index(size)], slab);
+    template <std::size_t _slab_size, free_memory_manager_options _options>
+    auto* FREE_LIST(const free_memory_manager<_slab_size, _options>& manager, std::size_t size) {
+        using size_classes_t = typename free_memory_manager<_slab_size, _options>::size_classes_t;
+
+        if (!IS_SIZE_CLASS(manager, size)) {
+            return manager._free_segments[manager.block_size_to_bucket_index(size)];
+        }
+
+        const auto class_index = size_classes_t::class_index(size);
+
+        return manager.has_class_at_index(class_index)
+            ? manager._free_slabs[class_index][manager.fullest_occupancy_class(class_index)]
+            : nullptr;
+    }
+
+    template <std::size_t _slab_size, free_memory_manager_options _options, typename... _sizes>
+    void ASSERT_MASK_EQ(const free_memory_manager<_slab_size, _options>& manager, _sizes... sizes) {
+        using size_classes_t = typename free_memory_manager<_slab_size, _options>::size_classes_t;
+
+        ASSERT_EQ(manager._free_slabs_mask[0], ((IS_SIZE_CLASS(manager, sizes) ? 1ull << size_classes_t::class_index(sizes) : 0ull) | ... | 0ull));
+        ASSERT_EQ(manager._free_segments_mask, ((IS_SIZE_CLASS(manager, sizes) ? 0ull : 1ull << manager.block_size_to_bucket_index(sizes)) | ... | 0ull));
+    }
+
+    template <std::size_t _slab_size, free_memory_manager_options _options>
+    void ASSERT_BUCKET_EQ(const free_memory_manager<_slab_size, _options>& manager, std::size_t size, const typename free_memory_manager<_slab_size, _options>::slab_t* slab) {
+        ASSERT_EQ(FREE_LIST(manager, size), slab);
     }
 
-    template <std::size_t _slab_size>
-    void ASSERT_BUCKET_EQ(const free_memory_manager<_slab_size>& manager, std::size_t size, nullptr_t) {
-        ASSERT_EQ(manager._free_segments[manager.block_size_to_bucket_index(size)], nullptr);
+    template <std::size_t _slab_size, free_memory_manager_options _options>
+    void ASSERT_BUCKET_EQ(const free_memory_manager<_slab_size, _options>& manager, std::size_t size, nullptr_t) {
+        ASSERT_EQ(FREE_LIST(manager, size), nullptr);
     }
 
-    template <std::size_t _slab_size>
-    void ASSERT_IS_IN_SLAB(void* ptr, memory_slab<_slab_size>* slab) {
+    template <std::size_t _slab_size, std::size_t _bitmap_words>
+    void ASSERT_IS_IN_SLAB(void* ptr, memory_slab<_slab_size, _bitmap_words>* slab) {
         ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) / _slab_size * _slab_size, reinterpret_cast<std::uintptr_t>(slab));
     }
 };
@@ -422,4 +453,1101 @@ TEST_F(FreeMemoryManagerTest, AllocatesBigObjectsFromMultipleSlabs) {
     ASSERT_IS_IN_SLAB(ptr3, &slabs[8]);
 }
 
+TEST_F(FreeMemoryManagerTest, PurgesEmptyRunsAboveThreshold) {
+    mmap_block_allocator<1024 * 1024, 64 * 1024, 4096> block_allocator;
+    auto* slabs = reinterpret_cast<memory_slab<4096>*>(block_allocator.allocate_at_least(16 * 4096).ptr);
+    launder_slab(slabs, 16);
+
+    free_memory_manager<4096, { .purge_threshold = 16 * 1024 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    auto* ptr = static_cast<std::byte*>(manager.allocate(30000));
+    std::memset(ptr, 0xab, 30000);
+    manager.deallocate(ptr);
+
+    ASSERT_EQ(ptr[4096], std::byte{ 0xab });
+
+    manager.purge();
+
+    ASSERT_EQ(ptr[4096], std::byte{ 0 });
+    ASSERT_EQ(ptr[29999], std::byte{ 0 });
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 16 * 4096 - memory_slab<4096>::data_block_offset);
+    ASSERT_EQ(manager.allocate(30000), ptr);
+}
+
+TEST_F(FreeMemoryManagerTest, DoesNotPurgeRunsBelowThreshold) {
+    mmap_block_allocator<1024 * 1024, 64 * 1024, 4096> block_allocator;
+    auto* slabs = reinterpret_cast<memory_slab<4096>*>(block_allocator.allocate_at_least(16 * 4096).ptr);
+    launder_slab(slabs, 16);
+
+    free_memory_manager<4096, { .purge_threshold = 16 * 1024 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    auto* ptr1 = static_cast<std::byte*>(manager.allocate(8000));
+    auto* ptr2 = static_cast<std::byte*>(manager.allocate(8));
+    std::memset(ptr1, 0xab, 8000);
+    manager.deallocate(ptr1);
+    manager.purge();
+
+    ASSERT_EQ(ptr1[4096], std::byte{ 0xab });
+    ASSERT_NE(ptr2, nullptr);
+}
+
+TEST_F(FreeMemoryManagerTest, PurgesAutomaticallyAfterDecay) {
+    mmap_block_allocator<1024 * 1024, 64 * 1024, 4096> block_allocator;
+    auto* slabs = reinterpret_cast<memory_slab<4096>*>(block_allocator.allocate_at_least(16 * 4096).ptr);
+    launder_slab(slabs, 16);
+
+    free_memory_manager<4096, { .purge_threshold = 16 * 1024, .purge_decay_ms = 1 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    auto* ptr = static_cast<std::byte*>(manager.allocate(30000));
+    std::memset(ptr, 0xab, 30000);
+    manager.deallocate(ptr);
+
+    ASSERT_EQ(ptr[4096], std::byte{ 0 });
+}
+
+TEST_F(FreeMemoryManagerTest, PurgesRunsReleasedWithinDecayPeriodOnAllocation) {
+    mmap_block_allocator<1024 * 1024, 128 * 1024, 4096> block_allocator;
+    auto* slabs = reinterpret_cast<memory_slab<4096>*>(block_allocator.allocate_at_least(32 * 4096).ptr);
+    launder_slab(slabs, 32);
+
+    free_memory_manager<4096, { .purge_threshold = 16 * 1024, .purge_decay_ms = 50 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    auto* ptr1 = static_cast<std::byte*>(manager.allocate(30000));
+    auto* ptr2 = static_cast<std::byte*>(manager.allocate(30000));
+    std::memset(ptr1, 0xab, 30000);
+    std::memset(ptr2, 0xab, 30000);
+
+    manager.deallocate(ptr1);
+    manager.deallocate(ptr2);
+
+    ASSERT_EQ(ptr1[4096], std::byte{ 0 });
+    ASSERT_EQ(ptr2[4096], std::byte{ 0xab });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+
+    for (std::size_t i = 0; i < 64; ++i) {
+        manager.deallocate(manager.allocate(8));
+    }
+
+    ASSERT_EQ(ptr2[4096], std::byte{ 0 });
+}
+
+TEST_F(FreeMemoryManagerTest, SkipsRunsThatAreAlreadyPurged) {
+    mmap_block_allocator<1024 * 1024, 128 * 1024, 4096> block_allocator;
+    auto* slabs = reinterpret_cast<memory_slab<4096>*>(block_allocator.allocate_at_least(32 * 4096).ptr);
+    launder_slab(slabs, 32);
+
+    free_memory_manager<4096, { .purge_threshold = 16 * 1024 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    auto* ptr1 = static_cast<std::byte*>(manager.allocate(30000));
+    auto* separator = manager.allocate(8);
+    auto* ptr2 = static_cast<std::byte*>(manager.allocate(30000));
+
+    manager.deallocate(ptr1);
+    manager.purge();
+
+    ASSERT_TRUE(slabs[0].is_purged());
+
+    // Dirties the pages of the purged run behind the back of the manager.
+    ptr1[4096] = std::byte{ 0xcd };
+    std::memset(ptr2, 0xab, 30000);
+
+    manager.deallocate(ptr2);
+    manager.purge();
+
+    ASSERT_EQ(ptr1[4096], std::byte{ 0xcd });
+    ASSERT_EQ(ptr2[4096], std::byte{ 0 });
+
+    manager.deallocate(separator);
+
+    ASSERT_FALSE(slabs[0].is_purged());
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 32 * 4096 - memory_slab<4096>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, AllocatesBatchWithinSingleSlab) {
+    memory_slab<256> slabs[10];
+    launder_slab(slabs, 10);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* first = manager.allocate(8);
+    std::array<void*, 5> ptrs;
+    const auto allocated = manager.allocate_batch(8, ptrs.size(), ptrs.data());
+
+    ASSERT_EQ(allocated, ptrs.size());
+    for (std::size_t i = 0; i < ptrs.size(); ++i) {
+        ASSERT_IS_IN_SLAB(ptrs[i], &slabs[0]);
+        ASSERT_EQ(ptrs[i], static_cast<std::byte*>(first) + (i + 1) * 8);
+        ASSERT_TRUE(slabs[0].has_element(i + 1));
+    }
+    ASSERT_EQ(slabs[0].header.metadata.mask, 0b111111);
+    ASSERT_BUCKET_EQ(manager, 8, &slabs[0]);
+}
+
+TEST_F(FreeMemoryManagerTest, AllocatesBatchAcrossSlabs) {
+    memory_slab<256> slabs[10];
+    launder_slab(slabs, 10);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    const auto elements_per_slab = (256 - memory_slab<256>::data_block_offset) / 16;
+    std::vector<void*> ptrs(elements_per_slab * 2 + 1);
+    const auto allocated = manager.allocate_batch(16, ptrs.size(), ptrs.data());
+
+    ASSERT_EQ(allocated, ptrs.size());
+    ASSERT_TRUE(slabs[0].is_full());
+    ASSERT_TRUE(slabs[1].is_full());
+    ASSERT_EQ(slabs[2].header.metadata.mask, 1);
+    ASSERT_IS_IN_SLAB(ptrs[0], &slabs[0]);
+    ASSERT_IS_IN_SLAB(ptrs[elements_per_slab], &slabs[1]);
+    ASSERT_IS_IN_SLAB(ptrs[elements_per_slab * 2], &slabs[2]);
+    ASSERT_MASK_EQ(manager, 16, 256 * 7 - memory_slab<256>::data_block_offset);
+    ASSERT_EQ(std::set<void*>(ptrs.begin(), ptrs.end()).size(), ptrs.size());
+}
+
+TEST_F(FreeMemoryManagerTest, AllocatesPartialBatchWhenFull) {
+    memory_slab<256> slabs[2];
+    launder_slab(slabs, 2);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    std::array<void*, 4> ptrs;
+    const auto allocated = manager.allocate_batch(128, ptrs.size(), ptrs.data());
+
+    ASSERT_EQ(allocated, 2);
+    ASSERT_IS_IN_SLAB(ptrs[0], &slabs[0]);
+    ASSERT_IS_IN_SLAB(ptrs[1], &slabs[1]);
+}
+
+TEST_F(FreeMemoryManagerTest, DeallocatesBatch) {
+    memory_slab<256> slabs[10];
+    launder_slab(slabs, 10);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    const auto elements_per_slab = (256 - memory_slab<256>::data_block_offset) / 16;
+    std::vector<void*> ptrs(elements_per_slab * 2 + 1);
+    manager.allocate_batch(16, ptrs.size(), ptrs.data());
+    manager.deallocate_batch(ptrs.data() + 1, elements_per_slab);
+
+    ASSERT_TRUE(slabs[0].has_element(0));
+    ASSERT_FALSE(slabs[0].has_element(1));
+    ASSERT_FALSE(slabs[1].has_element(0));
+    ASSERT_TRUE(slabs[1].has_element(1));
+    ASSERT_FALSE(slabs[1].is_full());
+    ASSERT_BUCKET_EQ(manager, 16, &slabs[1]);
+
+    manager.deallocate_batch(ptrs.data(), 1);
+    manager.deallocate_batch(ptrs.data() + elements_per_slab + 1, elements_per_slab);
+
+    ASSERT_MASK_EQ(manager, 256 * 10 - memory_slab<256>::data_block_offset);
+    ASSERT_BUCKET_EQ(manager, 256 * 10 - memory_slab<256>::data_block_offset, &slabs[0]);
+    ASSERT_TRUE(slabs[0].is_empty());
+    ASSERT_EQ(slabs[0].header.neighbors.next, nullptr);
+}
+
+TEST_F(FreeMemoryManagerTest, DeallocatesInterleavedBatchBySlab) {
+    memory_slab<256> slabs[64];
+    launder_slab(slabs, 64);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    const auto elements_per_slab = (256 - memory_slab<256>::data_block_offset) / 16;
+    std::vector<void*> ptrs(elements_per_slab * 2);
+    manager.allocate_batch(16, ptrs.size(), ptrs.data());
+
+    std::vector<void*> interleaved;
+    for (std::size_t i = 0; i < elements_per_slab / 2; ++i) {
+        interleaved.push_back(ptrs[elements_per_slab + i]);
+        interleaved.push_back(ptrs[i]);
+    }
+
+    manager.deallocate_batch(interleaved.data(), interleaved.size());
+
+    // Both slabs are released as a group, in address order, so the second one ends up at the head of the list.
+    ASSERT_FALSE(slabs[0].has_element(0));
+    ASSERT_TRUE(slabs[0].has_element(elements_per_slab / 2));
+    ASSERT_FALSE(slabs[1].has_element(0));
+    ASSERT_BUCKET_EQ(manager, 16, &slabs[1]);
+    ASSERT_EQ(slabs[1].header.free_list.next, &slabs[0]);
+
+    std::vector<void*> many(elements_per_slab * 40);
+    manager.allocate_batch(16, many.size(), many.data());
+    many.insert(many.end(), ptrs.begin() + elements_per_slab / 2, ptrs.begin() + elements_per_slab);
+    many.insert(many.end(), ptrs.begin() + elements_per_slab + elements_per_slab / 2, ptrs.end());
+    std::shuffle(many.begin(), many.end(), std::mt19937{ 42 });
+
+    manager.deallocate_batch(many.data(), many.size());
+
+    ASSERT_MASK_EQ(manager, 256 * 64 - memory_slab<256>::data_block_offset);
+    ASSERT_TRUE(slabs[0].is_empty());
+    ASSERT_EQ(slabs[0].header.neighbors.next, nullptr);
+}
+
+TEST_F(FreeMemoryManagerTest, FillsSlabWithMoreThan64Elements) {
+    using slab_t = free_memory_manager<4096, { .bitmap_words = 8 }>::slab_t;
+
+    slab_t slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<4096, { .bitmap_words = 8 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    std::vector<void*> ptrs;
+    do {
+        ptrs.push_back(manager.allocate(8));
+        ASSERT_IS_IN_SLAB(ptrs.back(), &slabs[0]);
+    } while (!slabs[0].is_full());
+
+    ASSERT_EQ(ptrs.size(), slab_t::data_block_size / 8);
+    ASSERT_EQ(std::set<void*>(ptrs.begin(), ptrs.end()).size(), ptrs.size());
+    ASSERT_BUCKET_EQ(manager, 8, nullptr);
+
+    void* ptr = manager.allocate(8);
+    ASSERT_IS_IN_SLAB(ptr, &slabs[1]);
+
+    manager.deallocate(ptrs[100]);
+    ASSERT_FALSE(slabs[0].has_element(100));
+    ASSERT_EQ(manager.allocate(8), ptrs[100]);
+
+    ptrs.push_back(ptr);
+    for (auto* ptr : ptrs) {
+        manager.deallocate(ptr);
+    }
+
+    ASSERT_MASK_EQ(manager, 4096 * 4 - slab_t::data_block_offset);
+    ASSERT_EQ(slabs[0].header.neighbors.next, nullptr);
+}
+
+TEST_F(FreeMemoryManagerTest, AllocatesAndDeallocatesBatchAcrossBitmapWords) {
+    using slab_t = free_memory_manager<4096, { .bitmap_words = 8 }>::slab_t;
+
+    slab_t slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<4096, { .bitmap_words = 8 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    std::vector<void*> ptrs(300);
+    const auto allocated = manager.allocate_batch(8, ptrs.size(), ptrs.data());
+
+    ASSERT_EQ(allocated, ptrs.size());
+    for (std::size_t i = 0; i < ptrs.size(); ++i) {
+        ASSERT_EQ(ptrs[i], slabs[0].get_element(i));
+        ASSERT_TRUE(slabs[0].has_element(i));
+    }
+    ASSERT_FALSE(slabs[0].has_element(300));
+    ASSERT_EQ(slabs[0].get_first_free_element(), 300);
+
+    manager.deallocate_batch(ptrs.data() + 50, 200);
+
+    ASSERT_TRUE(slabs[0].has_element(49));
+    ASSERT_FALSE(slabs[0].has_element(50));
+    ASSERT_FALSE(slabs[0].has_element(249));
+    ASSERT_TRUE(slabs[0].has_element(250));
+
+    manager.deallocate_batch(ptrs.data(), 50);
+    manager.deallocate_batch(ptrs.data() + 250, 50);
+
+    ASSERT_TRUE(slabs[0].is_empty());
+    ASSERT_MASK_EQ(manager, 4096 * 4 - slab_t::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, AllocatesFromNonPowerOfTwoSizeClasses) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024, { .size_classes_per_doubling = 4 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr1 = manager.allocate(33);
+    void* ptr2 = manager.allocate(40);
+    void* ptr3 = manager.allocate(65);
+
+    ASSERT_IS_IN_SLAB(ptr1, &slabs[0]);
+    ASSERT_IS_IN_SLAB(ptr2, &slabs[0]);
+    ASSERT_IS_IN_SLAB(ptr3, &slabs[1]);
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 48);
+    ASSERT_EQ(slabs[1].header.metadata.element_size, 80);
+    ASSERT_EQ(ptr2, slabs[0].get_element(1));
+
+    ASSERT_MASK_EQ(manager, 48, 80, 1024 * 2 - memory_slab<1024>::data_block_offset);
+    ASSERT_BUCKET_EQ(manager, 48, &slabs[0]);
+    ASSERT_BUCKET_EQ(manager, 80, &slabs[1]);
+
+    manager.deallocate(ptr1);
+    manager.deallocate(ptr3);
+
+    ASSERT_EQ(manager.allocate(48), ptr1);
+
+    manager.deallocate(ptr1);
+    manager.deallocate(ptr2);
+
+    ASSERT_MASK_EQ(manager, 1024 * 4 - memory_slab<1024>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, FitsLargeSizeClassInSingleSlab) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024, { .size_classes_per_doubling = 4 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr = manager.allocate(600);
+
+    ASSERT_IS_IN_SLAB(ptr, &slabs[0]);
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 640);
+    ASSERT_EQ(slabs[0].header.neighbors.next, &slabs[1]);
+    ASSERT_EQ(manager.required_segment_size(600), 1024);
+
+    manager.deallocate(ptr);
+
+    ASSERT_MASK_EQ(manager, 1024 * 4 - memory_slab<1024>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, AllocatesBatchFromNonPowerOfTwoSizeClass) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024, { .size_classes_per_doubling = 4 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptrs[25];
+    ASSERT_EQ(manager.allocate_batch(96, 25, ptrs), 25);
+
+    for (std::size_t i = 0; i < 10; ++i) {
+        ASSERT_EQ(ptrs[i], slabs[0].get_element(i));
+    }
+    for (std::size_t i = 10; i < 20; ++i) {
+        ASSERT_EQ(ptrs[i], slabs[1].get_element(i - 10));
+    }
+
+    manager.deallocate_batch(ptrs, 25);
+
+    ASSERT_MASK_EQ(manager, 1024 * 4 - memory_slab<1024>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, SupportsMoreThan64SizeClasses) {
+    using manager_t = free_memory_manager<4096, { .size_classes_per_doubling = 16 }>;
+    using size_classes_t = manager_t::size_classes_t;
+
+    static_assert(size_classes_t::count() > 64);
+
+    auto slabs = std::make_unique<memory_slab<4096>[]>(128);
+    launder_slab(slabs.get(), 128);
+
+    manager_t manager;
+    manager.add_new_memory_segment(slabs.get());
+
+    std::vector<void*> ptrs;
+    std::size_t classes = 0;
+
+    for (std::size_t size = 1; size < manager_t::slab_t::data_block_size; size = size_classes_t::class_size(size) + 1, ++classes) {
+        const auto class_size = std::min(size_classes_t::class_size(size), 0 + manager_t::slab_t::data_block_size);
+        auto* const first = static_cast<std::byte*>(manager.allocate(size));
+        auto* const second = static_cast<std::byte*>(manager.allocate(size));
+
+        ASSERT_EQ(memory_slab<4096>::from_pointer(first)->header.metadata.element_size, class_size);
+
+        if (manager_t::slab_t::data_block_size / class_size >= 2) {
+            ASSERT_EQ(second, first + class_size);
+        }
+
+        ptrs.push_back(first);
+        ptrs.push_back(second);
+    }
+
+    ASSERT_EQ(classes, size_classes_t::count());
+
+    for (auto* const ptr : ptrs) {
+        manager.deallocate(ptr);
+    }
+
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 128 * 4096 - memory_slab<4096>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, AlignsElementsInsideSlab) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr1 = manager.allocate(48, 64);
+    void* ptr2 = manager.allocate(48, 64);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr1) % 64, 0);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr2) % 64, 0);
+    ASSERT_EQ(ptr1, slabs[0].get_element(0));
+    ASSERT_EQ(ptr2, slabs[0].get_element(1));
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 64);
+}
+
+TEST_F(FreeMemoryManagerTest, KeepsNaturalAlignmentForSmallAlignments) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr1 = manager.allocate(1, 8);
+    void* ptr2 = manager.allocate(1, 8);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr2) - reinterpret_cast<std::uintptr_t>(ptr1), 8);
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 8);
+}
+
+TEST_F(FreeMemoryManagerTest, CarvesAlignedSpanFromRun) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr = manager.allocate(100, 256);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 256, 0);
+    ASSERT_IS_IN_SLAB(ptr, &slabs[0]);
+    ASSERT_EQ(ptr, reinterpret_cast<std::byte*>(&slabs[0]) + 256);
+    ASSERT_TRUE(slabs[0].is_full());
+    ASSERT_MASK_EQ(manager, 1024 * 3 - memory_slab<1024>::data_block_offset);
+
+    manager.deallocate(ptr);
+
+    ASSERT_TRUE(slabs[0].is_empty());
+    ASSERT_MASK_EQ(manager, 1024 * 4 - memory_slab<1024>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, CarvesLargeAlignedSpanFromMultiSlabRun) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr = manager.allocate(1500, 512);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 512, 0);
+    ASSERT_IS_IN_SLAB(ptr, &slabs[0]);
+    ASSERT_EQ(slabs[0].header.neighbors.next, &slabs[2]);
+    ASSERT_GE(manager.required_segment_size(1500, 512), 1024 * 2);
+
+    std::memset(ptr, 0xff, 1500);
+    manager.deallocate(ptr);
+
+    ASSERT_MASK_EQ(manager, 1024 * 4 - memory_slab<1024>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, RejectsAlignmentAboveMaximum) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024> manager;
+    manager.add_new_memory_segment(slabs);
+
+    ASSERT_EQ(free_memory_manager<1024>::max_alignment, 512);
+    ASSERT_EQ(manager.allocate(8, 1024), nullptr);
+    ASSERT_MASK_EQ(manager, 1024 * 4 - memory_slab<1024>::data_block_offset);
+}
+TEST_F(FreeMemoryManagerTest, ExpandsLargeAllocationIntoEmptyNeighbor) {
+    memory_slab<256> slabs[10];
+    launder_slab(slabs, 10);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr = manager.allocate(400);
+
+    ASSERT_EQ(slabs[0].header.neighbors.next, &slabs[2]);
+    ASSERT_TRUE(manager.try_expand(ptr, 900));
+
+    ASSERT_TRUE(slabs[0].is_full());
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 256 * 4 - memory_slab<256>::data_block_offset);
+    ASSERT_EQ(slabs[0].header.neighbors.next, &slabs[4]);
+    ASSERT_EQ(slabs[4].header.neighbors.previous, &slabs[0]);
+    ASSERT_GE(manager.usable_size(ptr), 900);
+    ASSERT_MASK_EQ(manager, 256 * 6 - memory_slab<256>::data_block_offset);
+
+    std::memset(ptr, 0xff, 900);
+    manager.deallocate(ptr);
+
+    ASSERT_MASK_EQ(manager, 256 * 10 - memory_slab<256>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, FailsToExpandIntoOccupiedNeighbor) {
+    memory_slab<256> slabs[10];
+    launder_slab(slabs, 10);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr1 = manager.allocate(400);
+    void* ptr2 = manager.allocate(8);
+
+    ASSERT_IS_IN_SLAB(ptr2, &slabs[2]);
+    ASSERT_FALSE(manager.try_expand(ptr1, 1000));
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 256 * 2 - memory_slab<256>::data_block_offset);
+    ASSERT_EQ(slabs[0].header.neighbors.next, &slabs[2]);
+}
+
+TEST_F(FreeMemoryManagerTest, ShrinksLargeAllocationInPlace) {
+    memory_slab<256> slabs[10];
+    launder_slab(slabs, 10);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr1 = manager.allocate(900);
+    void* ptr2 = manager.allocate(8);
+
+    ASSERT_IS_IN_SLAB(ptr2, &slabs[4]);
+    ASSERT_TRUE(manager.try_expand(ptr1, 300));
+
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 256 * 2 - memory_slab<256>::data_block_offset);
+    ASSERT_EQ(slabs[0].header.neighbors.next, &slabs[2]);
+    ASSERT_TRUE(slabs[2].is_empty());
+    ASSERT_EQ(slabs[2].header.neighbors.next, &slabs[4]);
+    ASSERT_MASK_EQ(manager, 8, 256 * 2 - memory_slab<256>::data_block_offset, 256 * 5 - memory_slab<256>::data_block_offset);
+
+    manager.deallocate(ptr2);
+
+    ASSERT_TRUE(manager.try_expand(ptr1, 150));
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 256 - memory_slab<256>::data_block_offset);
+    ASSERT_MASK_EQ(manager, 256 * 9 - memory_slab<256>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, ExpandsSmallElementsOnlyWithinTheirSizeClass) {
+    memory_slab<256> slabs[10];
+    launder_slab(slabs, 10);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr = manager.allocate(5);
+
+    ASSERT_EQ(manager.usable_size(ptr), 8);
+    ASSERT_TRUE(manager.try_expand(ptr, 8));
+    ASSERT_FALSE(manager.try_expand(ptr, 9));
+}
+
+TEST_F(FreeMemoryManagerTest, ReallocatesByCopyingWhenExpansionFails) {
+    memory_slab<256> slabs[10];
+    launder_slab(slabs, 10);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(slabs);
+
+    auto* ptr1 = static_cast<std::uint8_t*>(manager.allocate(8));
+    auto* ptr2 = manager.allocate(8);
+
+    for (std::uint8_t i = 0; i < 8; ++i) {
+        ptr1[i] = i;
+    }
+
+    auto* ptr3 = static_cast<std::uint8_t*>(manager.reallocate(ptr1, 100));
+
+    ASSERT_NE(ptr3, ptr1);
+    ASSERT_FALSE(slabs[0].has_element(0));
+    ASSERT_TRUE(slabs[0].has_element(1));
+    for (std::uint8_t i = 0; i < 8; ++i) {
+        ASSERT_EQ(ptr3[i], i);
+    }
+
+    auto* ptr4 = static_cast<std::uint8_t*>(manager.reallocate(ptr3, 120));
+
+    ASSERT_EQ(ptr4, ptr3);
+
+    manager.deallocate(ptr2);
+    manager.deallocate(ptr4);
+    ASSERT_MASK_EQ(manager, 256 * 10 - memory_slab<256>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, ReallocatesAlignedRunInPlace) {
+    memory_slab<1024> slabs[4];
+    launder_slab(slabs, 4);
+
+    free_memory_manager<1024> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr = manager.allocate(100, 256);
+
+    ASSERT_EQ(manager.usable_size(ptr), 1024 - 256);
+    ASSERT_TRUE(manager.try_expand(ptr, 2000));
+    ASSERT_GE(manager.usable_size(ptr), 2000);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 256, 0);
+
+    manager.deallocate(ptr);
+
+    ASSERT_MASK_EQ(manager, 1024 * 4 - memory_slab<1024>::data_block_offset);
+}
+template <free_memory_manager_options _options>
+struct fragmented_manager {
+    // Leaves empty runs of 4 (slabs 0-3) and 3 (slabs 5-7) slabs in the same bucket, released in the given order.
+    fragmented_manager(bool release_smaller_run_first) {
+        launder_slab(slabs, 20);
+        manager.add_new_memory_segment(slabs);
+
+        void* larger_run = manager.allocate(900);
+        manager.allocate(150);
+        void* smaller_run = manager.allocate(650);
+        manager.allocate(150);
+
+        if (release_smaller_run_first) {
+            manager.deallocate(smaller_run);
+            manager.deallocate(larger_run);
+        }
+        else {
+            manager.deallocate(larger_run);
+            manager.deallocate(smaller_run);
+        }
+    }
+
+    memory_slab<256> slabs[20];
+    free_memory_manager<256, _options> manager;
+};
+
+TEST_F(FreeMemoryManagerTest, FirstFitTakesMostRecentlyReleasedRun) {
+    fragmented_manager<{}> fragmented{ true };
+
+    ASSERT_IS_IN_SLAB(fragmented.manager.allocate(400), &fragmented.slabs[0]);
+}
+
+TEST_F(FreeMemoryManagerTest, BestFitTakesSmallestSufficientRun) {
+    fragmented_manager<{ .placement = placement_policy::best_fit }> fragmented{ true };
+
+    ASSERT_IS_IN_SLAB(fragmented.manager.allocate(400), &fragmented.slabs[5]);
+    ASSERT_EQ(fragmented.slabs[7].header.neighbors.previous, &fragmented.slabs[5]);
+    ASSERT_TRUE(fragmented.slabs[7].is_empty());
+}
+
+TEST_F(FreeMemoryManagerTest, BestFitTakesExactRunFromLowerBucket) {
+    fragmented_manager<{ .placement = placement_policy::best_fit }> fragmented{ true };
+
+    void* ptr1 = fragmented.manager.allocate(400);
+    void* ptr2 = fragmented.manager.allocate(400);
+
+    ASSERT_IS_IN_SLAB(ptr1, &fragmented.slabs[5]);
+    ASSERT_IS_IN_SLAB(ptr2, &fragmented.slabs[0]);
+
+    // The 2 slabs left over from the larger run fit exactly, even though they sit in a bucket below the minimum one.
+    ASSERT_IS_IN_SLAB(fragmented.manager.allocate(300), &fragmented.slabs[2]);
+}
+
+TEST_F(FreeMemoryManagerTest, AddressOrderedTakesLowestAddressedRun) {
+    fragmented_manager<{ .placement = placement_policy::address_ordered }> fragmented{ false };
+
+    ASSERT_IS_IN_SLAB(fragmented.manager.allocate(400), &fragmented.slabs[0]);
+    ASSERT_IS_IN_SLAB(fragmented.manager.allocate(400), &fragmented.slabs[2]);
+    ASSERT_IS_IN_SLAB(fragmented.manager.allocate(400), &fragmented.slabs[5]);
+}
+
+TEST_F(FreeMemoryManagerTest, SortedPoliciesMergeReleasedRuns) {
+    fragmented_manager<{ .placement = placement_policy::best_fit }> fragmented{ true };
+
+    void* ptr = fragmented.manager.allocate(400);
+    fragmented.manager.deallocate(ptr);
+
+    ASSERT_EQ(fragmented.slabs[5].header.metadata.element_size, 256 * 3 - memory_slab<256>::data_block_offset);
+    ASSERT_EQ(fragmented.slabs[5].header.neighbors.next, &fragmented.slabs[8]);
+}
+
+template <free_memory_manager_options _options>
+struct partially_used_manager {
+    // Fills slabs 0 and 1 with 12 elements of 16 bytes each, then leaves 2 elements in slab 0 and 10 in slab 1,
+    // releasing the elements of slab 1 first.
+    partially_used_manager() {
+        launder_slab(slabs, 20);
+        manager.add_new_memory_segment(slabs);
+
+        for (auto*& ptr : ptrs) {
+            ptr = manager.allocate(16);
+        }
+
+        manager.deallocate(ptrs[22]);
+        manager.deallocate(ptrs[23]);
+
+        for (std::size_t i = 2; i < 12; ++i) {
+            manager.deallocate(ptrs[i]);
+        }
+    }
+
+    memory_slab<256> slabs[20];
+    free_memory_manager<256, _options> manager;
+    void* ptrs[24];
+};
+
+TEST_F(FreeMemoryManagerTest, SingleOccupancyClassTakesMostRecentlyReleasedSlab) {
+    partially_used_manager<{}> partially_used;
+
+    ASSERT_IS_IN_SLAB(partially_used.ptrs[0], &partially_used.slabs[0]);
+    ASSERT_IS_IN_SLAB(partially_used.ptrs[23], &partially_used.slabs[1]);
+    ASSERT_IS_IN_SLAB(partially_used.manager.allocate(16), &partially_used.slabs[0]);
+}
+
+TEST_F(FreeMemoryManagerTest, OccupancyClassesTakeFullestSlab) {
+    partially_used_manager<{ .occupancy_classes = 4 }> partially_used;
+
+    ASSERT_IS_IN_SLAB(partially_used.manager.allocate(16), &partially_used.slabs[1]);
+    ASSERT_IS_IN_SLAB(partially_used.manager.allocate(16), &partially_used.slabs[1]);
+    ASSERT_IS_IN_SLAB(partially_used.manager.allocate(16), &partially_used.slabs[0]);
+}
+
+TEST_F(FreeMemoryManagerTest, OccupancyClassesLetNearlyEmptySlabsDrain) {
+    partially_used_manager<{ .occupancy_classes = 4 }> partially_used;
+
+    partially_used.manager.allocate(16);
+    partially_used.manager.allocate(16);
+    partially_used.manager.deallocate(partially_used.ptrs[0]);
+    partially_used.manager.deallocate(partially_used.ptrs[1]);
+
+    ASSERT_TRUE(partially_used.slabs[0].is_empty());
+    ASSERT_TRUE(partially_used.slabs[1].is_full());
+    ASSERT_MASK_EQ(partially_used.manager, 256 - memory_slab<256>::data_block_offset, 256 * 18 - memory_slab<256>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, OccupancyClassesTrackBatchOperations) {
+    memory_slab<256> slabs[20];
+    launder_slab(slabs, 20);
+
+    free_memory_manager<256, { .occupancy_classes = 4 }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptrs[24];
+    ASSERT_EQ(manager.allocate_batch(16, 24, ptrs), 24);
+
+    manager.deallocate_batch(ptrs + 22, 2);
+    manager.deallocate_batch(ptrs + 2, 10);
+
+    void* batch[4];
+    ASSERT_EQ(manager.allocate_batch(16, 4, batch), 4);
+
+    ASSERT_IS_IN_SLAB(batch[0], &slabs[1]);
+    ASSERT_IS_IN_SLAB(batch[1], &slabs[1]);
+    ASSERT_IS_IN_SLAB(batch[2], &slabs[0]);
+    ASSERT_IS_IN_SLAB(batch[3], &slabs[0]);
+
+    manager.deallocate_batch(batch, 4);
+    manager.deallocate_batch(ptrs + 12, 10);
+    manager.deallocate_batch(ptrs, 2);
+
+    ASSERT_MASK_EQ(manager, 256 * 20 - memory_slab<256>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, CollectsAllocationStatistics) {
+    memory_slab<256> slabs[20];
+    launder_slab(slabs, 20);
+
+    free_memory_manager<256, { .collect_statistics = true }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr1 = manager.allocate(10);
+    void* ptr2 = manager.allocate(100);
+    void* ptr3 = manager.allocate(400);
+
+    auto statistics = manager.statistics();
+
+    ASSERT_EQ(statistics.class_allocations[4], 1);
+    ASSERT_EQ(statistics.class_allocations[7], 1);
+    ASSERT_EQ(statistics.large_allocations[8], 1);
+    ASSERT_EQ(statistics.live_bytes, 16 + 128 + 448);
+    ASSERT_EQ(statistics.reserved_bytes, 256 * 20);
+    ASSERT_EQ(statistics.requested_bytes, 10 + 100 + 400);
+    ASSERT_EQ(statistics.rounding_waste_bytes(), 6 + 28 + 48);
+    ASSERT_EQ(statistics.splits, 3);
+    ASSERT_EQ(statistics.merges, 0);
+
+    manager.deallocate(ptr1);
+    manager.deallocate(ptr2);
+    manager.deallocate(ptr3);
+
+    statistics = manager.statistics();
+
+    ASSERT_EQ(statistics.class_deallocations[4], 1);
+    ASSERT_EQ(statistics.class_deallocations[7], 1);
+    ASSERT_EQ(statistics.large_deallocations[8], 1);
+    ASSERT_EQ(statistics.live_bytes, 0);
+    ASSERT_EQ(statistics.merges, 3);
+
+    manager.remove_memory_segment(slabs);
+
+    ASSERT_EQ(manager.statistics().reserved_bytes, 0);
+}
+
+TEST_F(FreeMemoryManagerTest, CollectsBatchStatistics) {
+    memory_slab<256> slabs[20];
+    launder_slab(slabs, 20);
+
+    free_memory_manager<256, { .collect_statistics = true }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptrs[30];
+    ASSERT_EQ(manager.allocate_batch(16, 30, ptrs), 30);
+
+    ASSERT_EQ(manager.statistics().class_allocations[4], 30);
+    ASSERT_EQ(manager.statistics().live_bytes, 30 * 16);
+
+    manager.deallocate_batch(ptrs, 30);
+
+    ASSERT_EQ(manager.statistics().class_deallocations[4], 30);
+    ASSERT_EQ(manager.statistics().live_bytes, 0);
+}
+
+TEST_F(FreeMemoryManagerTest, CollectsResizeAndFailureStatistics) {
+    memory_slab<256> slabs[20];
+    launder_slab(slabs, 20);
+
+    free_memory_manager<256, { .collect_statistics = true }> manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr = manager.allocate(400);
+
+    ASSERT_TRUE(manager.try_expand(ptr, 900));
+    ASSERT_EQ(manager.statistics().live_bytes, 960);
+    ASSERT_EQ(manager.statistics().merges, 1);
+
+    ASSERT_EQ(manager.allocate(100000), nullptr);
+    ASSERT_EQ(manager.statistics().failed_allocations, 1);
+
+    manager.deallocate(ptr);
+
+    ASSERT_EQ(manager.statistics().live_bytes, 0);
+}
+
+TEST_F(FreeMemoryManagerTest, CacheColouringShiftsFirstElementOfSlabs) {
+    std::vector<memory_slab<4096>> slabs(8);
+    launder_slab(slabs.data(), slabs.size());
+
+    free_memory_manager<4096, { .cache_colouring = true }> manager;
+    manager.add_new_memory_segment(slabs.data());
+
+    std::set<std::uintptr_t> offsets;
+    std::vector<void*> ptrs;
+
+    for (std::size_t slab = 0; slab < 8; ++slab) {
+        for (std::size_t i = 0; i < 64; ++i) {
+            ptrs.push_back(manager.allocate(16));
+            ASSERT_IS_IN_SLAB(ptrs.back(), &slabs[slab]);
+            ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptrs.back()) % 16, 0);
+        }
+
+        offsets.insert(reinterpret_cast<std::uintptr_t>(ptrs[slab * 64]) % 4096);
+    }
+
+    ASSERT_EQ(offsets.size(), 8);
+
+    for (auto* ptr : ptrs) {
+        ASSERT_EQ(manager.usable_size(ptr), 16);
+        manager.deallocate(ptr);
+    }
+
+    ASSERT_MASK_EQ(manager, 4096 * 8 - memory_slab<4096>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, CacheColouringKeepsElementsAligned) {
+    std::vector<memory_slab<4096>> slabs(8);
+    launder_slab(slabs.data(), slabs.size());
+
+    free_memory_manager<4096, { .cache_colouring = true }> manager;
+    manager.add_new_memory_segment(slabs.data());
+
+    for (std::size_t i = 0; i < 64; ++i) {
+        void* ptr = manager.allocate(100, 128);
+        ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 128, 0);
+    }
+}
+
+TEST_F(FreeMemoryManagerTest, CacheColouringSupportsBatchOperations) {
+    std::vector<memory_slab<4096>> slabs(8);
+    launder_slab(slabs.data(), slabs.size());
+
+    free_memory_manager<4096, { .cache_colouring = true }> manager;
+    manager.add_new_memory_segment(slabs.data());
+
+    void* ptrs[200];
+    ASSERT_EQ(manager.allocate_batch(48, 200, ptrs), 200);
+
+    std::set<void*> unique_ptrs(ptrs, ptrs + 200);
+    ASSERT_EQ(unique_ptrs.size(), 200);
+
+    manager.deallocate_batch(ptrs, 200);
+
+    ASSERT_MASK_EQ(manager, 4096 * 8 - memory_slab<4096>::data_block_offset);
+}
+
+TEST_F(FreeMemoryManagerTest, OutOfBandHeadersUseWholeSlabs) {
+    using manager_t = free_memory_manager<256, { .segment_size = 16 * 1024, .out_of_band_headers = true }>;
+    using slab_t = manager_t::slab_t;
+
+    struct alignas(16 * 1024) segment_memory {
+        std::byte data[16 * 1024];
+    };
+
+    std::vector<segment_memory> segments(1);
+    auto* const slabs = launder_header_table<slab_t>(segments.data());
+
+    manager_t manager;
+    manager.add_new_memory_segment(slabs);
+
+    std::vector<void*> ptrs;
+
+    for (std::size_t i = 0; i < 16; ++i) {
+        ptrs.push_back(manager.allocate(16));
+        ASSERT_EQ(ptrs.back(), segments[0].data + slab_t::header_table_slabs * 256 + i * 16);
+    }
+
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 16);
+    ASSERT_TRUE(slabs[0].is_full());
+    ASSERT_MASK_EQ(manager, 256 * (slab_t::slab_count - 1));
+    ASSERT_BUCKET_EQ(manager, 256 * (slab_t::slab_count - 1), &slabs[1]);
+
+    for (auto* ptr : ptrs) {
+        ASSERT_EQ(manager.usable_size(ptr), 16);
+        manager.deallocate(ptr);
+    }
+
+    ASSERT_MASK_EQ(manager, 256 * slab_t::slab_count);
+    ASSERT_BUCKET_EQ(manager, 256 * slab_t::slab_count, &slabs[0]);
+}
+
+TEST_F(FreeMemoryManagerTest, OutOfBandHeadersSplitAndMergeRuns) {
+    using manager_t = free_memory_manager<256, { .segment_size = 16 * 1024, .out_of_band_headers = true }>;
+    using slab_t = manager_t::slab_t;
+
+    struct alignas(16 * 1024) segment_memory {
+        std::byte data[16 * 1024];
+    };
+
+    std::vector<segment_memory> segments(1);
+    auto* const slabs = launder_header_table<slab_t>(segments.data());
+
+    manager_t manager;
+    manager.add_new_memory_segment(slabs);
+
+    void* ptr1 = manager.allocate(1024);
+    void* ptr2 = manager.allocate(1000, 256);
+
+    ASSERT_EQ(ptr1, slabs[0].data_block());
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 1024);
+    ASSERT_EQ(slabs[4].header.neighbors.previous, &slabs[0]);
+    ASSERT_EQ(manager_t::max_alignment, 256);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr2) % 256, 0);
+    ASSERT_EQ(manager.usable_size(ptr2), 1024);
+
+    ASSERT_FALSE(manager.try_expand(ptr1, 2000));
+    ASSERT_TRUE(manager.try_expand(ptr2, 2000));
+    ASSERT_EQ(manager.usable_size(ptr2), 2048);
+    ASSERT_FALSE(manager.try_expand(ptr2, 20000));
+
+    manager.deallocate(ptr1);
+    manager.deallocate(ptr2);
+
+    ASSERT_MASK_EQ(manager, 256 * slab_t::slab_count);
+    ASSERT_BUCKET_EQ(manager, 256 * slab_t::slab_count, &slabs[0]);
+    ASSERT_EQ(slabs[0].header.neighbors.next, nullptr);
+}
+
+TEST_F(FreeMemoryManagerTest, CompactHeadersFitMoreElements) {
+    using manager_t = free_memory_manager<128, { .compact_headers = true }>;
+    using slab_t = manager_t::slab_t;
+
+    std::vector<slab_t> slabs(10);
+    launder_slab(slabs.data(), slabs.size());
+
+    manager_t manager;
+    manager.add_new_memory_segment(slabs.data());
+
+    std::vector<void*> ptrs;
+
+    for (std::size_t i = 0; i < 6; ++i) {
+        ptrs.push_back(manager.allocate(16));
+        ASSERT_EQ(ptrs.back(), slabs[0].data + i * 16);
+    }
+
+    ASSERT_EQ(0 + slab_t::data_block_offset, 32);
+    ASSERT_TRUE(slabs[0].is_full());
+    ASSERT_MASK_EQ(manager, 128 * 9 - 32);
+    ASSERT_BUCKET_EQ(manager, 128 * 9 - 32, &slabs[1]);
+    ASSERT_EQ(slabs[1].header.neighbors.previous, &slabs[0]);
+
+    void* large = manager.allocate(400);
+
+    ASSERT_EQ(large, slabs[1].data);
+    ASSERT_EQ(slabs[1].header.metadata.element_size, 128 * 4 - 32);
+    ASSERT_EQ(slabs[5].header.neighbors.previous, &slabs[1]);
+    ASSERT_TRUE(manager.try_expand(large, 600));
+    ASSERT_EQ(slabs[6].header.neighbors.previous, &slabs[1]);
+
+    for (auto* ptr : ptrs) {
+        manager.deallocate(ptr);
+    }
+
+    manager.deallocate(large);
+
+    ASSERT_MASK_EQ(manager, 128 * 10 - 32);
+    ASSERT_BUCKET_EQ(manager, 128 * 10 - 32, &slabs[0]);
+    ASSERT_EQ(slabs[0].header.neighbors.next, nullptr);
+}
+
+TEST_F(FreeMemoryManagerTest, CompactHeadersRejectAllocationsAbove4GiB) {
+    using manager_t = free_memory_manager<128, { .compact_headers = true }>;
+    using slab_t = manager_t::slab_t;
+
+    std::vector<slab_t> slabs(10);
+    launder_slab(slabs.data(), slabs.size());
+
+    manager_t manager;
+    manager.add_new_memory_segment(slabs.data());
+
+    ASSERT_EQ(manager_t::max_run_size, (std::size_t{ 1 } << 32) - 128);
+    ASSERT_EQ(manager.allocate(manager_t::max_run_size), nullptr);
+    ASSERT_EQ(manager.allocate(std::size_t{ 5 } << 30), nullptr);
+    ASSERT_EQ(manager.allocate(std::size_t{ 5 } << 30, 64), nullptr);
+    ASSERT_EQ(manager.allocate(std::numeric_limits<std::size_t>::max()), nullptr);
+    ASSERT_NE(manager.allocate(400), nullptr);
+}
+
+TEST_F(FreeMemoryManagerTest, CompactOutOfBandHeadersSupportTinySlabs) {
+    using manager_t = free_memory_manager<64, { .segment_size = 16 * 1024, .out_of_band_headers = true, .compact_headers = true }>;
+    using slab_t = manager_t::slab_t;
+
+    struct alignas(16 * 1024) segment_memory {
+        std::byte data[16 * 1024];
+    };
+
+    std::vector<segment_memory> segments(2);
+    manager_t manager;
+
+    for (auto& segment : segments) {
+        manager.add_new_memory_segment(launder_header_table<slab_t>(&segment));
+    }
+
+    ASSERT_EQ(sizeof(slab_t), 28);
+    ASSERT_EQ(slab_t::slab_count, 256 - slab_t::header_table_slabs);
+
+    std::vector<void*> ptrs;
+
+    for (std::size_t i = 0; i < 2 * slab_t::slab_count * 4; ++i) {
+        ptrs.push_back(manager.allocate(16));
+        ASSERT_NE(ptrs.back(), nullptr);
+    }
+
+    ASSERT_EQ(manager.allocate(16), nullptr);
+
+    for (auto* ptr : ptrs) {
+        manager.deallocate(ptr);
+    }
+
+    ASSERT_MASK_EQ(manager, 64 * slab_t::slab_count);
+}
+
 }
\ No newline at end of file
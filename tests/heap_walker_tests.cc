@@ -0,0 +1,117 @@
+#include "src/free_memory_manager.h"
+#include "src/heap_walker.h"
+#include "src/memory.h"
+#include "src/utils.h"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <vector>
+
+namespace allocator {
+
+struct segment_heap {
+    template <typename _visitor_t>
+    void walk_heap(_visitor_t&& visitor) const {
+        walk_segment(slabs, 0, visitor);
+    }
+
+    memory_slab<256> slabs[8];
+};
+
+TEST(HeapWalkerTests, ReportsSlabStates) {
+    segment_heap heap;
+    launder_slab(heap.slabs, 8);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(heap.slabs);
+
+    manager.allocate(16);
+    manager.allocate(16);
+    manager.allocate(400);
+
+    std::vector<heap_slab_info> slabs;
+    heap.walk_heap([&](const heap_slab_info& info) { slabs.push_back(info); });
+
+    ASSERT_EQ(slabs.size(), 3);
+
+    ASSERT_EQ(slabs[0].address, &heap.slabs[0]);
+    ASSERT_EQ(slabs[0].state, slab_state::small_objects);
+    ASSERT_EQ(slabs[0].slabs, 1);
+    ASSERT_EQ(slabs[0].element_size, 16);
+    ASSERT_EQ(slabs[0].elements, 2);
+    ASSERT_EQ(slabs[0].max_elements, 12);
+
+    ASSERT_EQ(slabs[1].address, &heap.slabs[1]);
+    ASSERT_EQ(slabs[1].state, slab_state::large_allocation);
+    ASSERT_EQ(slabs[1].slabs, 2);
+    ASSERT_EQ(slabs[1].size, 512);
+
+    ASSERT_EQ(slabs[2].address, &heap.slabs[3]);
+    ASSERT_EQ(slabs[2].state, slab_state::free_run);
+    ASSERT_EQ(slabs[2].slabs, 5);
+    ASSERT_EQ(slabs[2].size, 5 * 256);
+}
+
+TEST(HeapWalkerTests, PrintsFragmentationMap) {
+    segment_heap heap;
+    launder_slab(heap.slabs, 8);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(heap.slabs);
+
+    for (std::size_t i = 0; i < 12; ++i) {
+        manager.allocate(16);
+    }
+
+    void* ptr = manager.allocate(100);
+    manager.allocate(400);
+    manager.deallocate(ptr);
+
+    std::ostringstream map;
+    print_fragmentation_map(map, heap, 4);
+
+    ASSERT_EQ(map.str(), "9.#=\n....\n");
+}
+
+TEST(HeapWalkerTests, PrintsSizeHistogram) {
+    segment_heap heap;
+    launder_slab(heap.slabs, 8);
+
+    free_memory_manager<256> manager;
+    manager.add_new_memory_segment(heap.slabs);
+
+    manager.allocate(100);
+    manager.allocate(400);
+
+    std::ostringstream histogram;
+    print_size_histogram(histogram, heap);
+
+    ASSERT_EQ(histogram.str(),
+        "small object slabs by element size:\n"
+        "  128: 1 (256 bytes)\n"
+        "large allocations by size:\n"
+        "  512: 1 (512 bytes)\n"
+        "free runs by size:\n"
+        "  1024: 1 (1280 bytes)\n"
+        "small object slab waste: 0.5\n"
+        "free space fragmentation: 0\n");
+}
+
+TEST(HeapWalkerTests, WalksAllBlocksOfMemory) {
+    mmap_memory<1024> memory;
+
+    memory.allocate(100);
+    memory.allocate(2 * 1024 * 1024);
+
+    std::size_t segments = 0;
+    std::size_t large_allocations = 0;
+
+    memory.walk_heap([&](const heap_slab_info& info) {
+        segments = std::max(segments, info.segment_index + 1);
+        large_allocations += info.state == slab_state::large_allocation;
+    });
+
+    ASSERT_EQ(segments, 2);
+    ASSERT_EQ(large_allocations, 1);
+}
+
+}
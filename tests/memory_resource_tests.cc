@@ -0,0 +1,103 @@
+#include "src/memory.h"
+#include "src/memory_resource.h"
+#include <gtest/gtest.h>
+#include <list>
+#include <map>
+#include <memory_resource>
+#include <vector>
+
+namespace allocator {
+
+TEST(MemoryResourceTest, AllocatesAndDeallocates) {
+    in_place_memory memory;
+    memory_resource resource{ memory };
+
+    void* ptr1 = resource.allocate(8);
+    void* ptr2 = resource.allocate(8);
+    resource.deallocate(ptr1, 8);
+    void* ptr3 = resource.allocate(8);
+
+    ASSERT_NE(ptr1, ptr2);
+    ASSERT_EQ(ptr1, ptr3);
+}
+
+TEST(MemoryResourceTest, RespectsAlignment) {
+    in_place_memory memory;
+    memory_resource resource{ memory };
+
+    void* unaligned = resource.allocate(1, 1);
+    void* ptr = resource.allocate(1, 16);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr) % 16, 0);
+
+    resource.deallocate(ptr, 1, 16);
+    resource.deallocate(unaligned, 1, 1);
+}
+
+TEST(MemoryResourceTest, ThrowsWhenExhausted) {
+    free_memory_manager<256> manager;
+    memory_slab<256> slabs[2];
+    launder_slab(slabs, 2);
+    manager.add_new_memory_segment(slabs);
+    memory_resource resource{ manager };
+
+    ASSERT_THROW((void)resource.allocate(1024), std::bad_alloc);
+}
+
+TEST(MemoryResourceTest, ComparesEqualForSameMemory) {
+    in_place_memory memory1;
+    in_place_memory memory2;
+    memory_resource resource1{ memory1 };
+    memory_resource resource2{ memory1 };
+    memory_resource resource3{ memory2 };
+
+    ASSERT_TRUE(resource1.is_equal(resource2));
+    ASSERT_FALSE(resource1.is_equal(resource3));
+    ASSERT_FALSE(resource1.is_equal(*std::pmr::new_delete_resource()));
+}
+
+TEST(MemoryResourceTest, BacksPmrContainers) {
+    mmap_memory<1024> memory;
+    memory_resource resource{ memory };
+
+    std::pmr::map<int, int> map{ &resource };
+    std::pmr::list<int> list{ &resource };
+    std::pmr::vector<int> vector{ &resource };
+
+    for (int i = 0; i < 10000; ++i) {
+        map[i] = i;
+        list.push_back(i);
+        vector.push_back(i);
+    }
+
+    for (int i = 0; i < 10000; i += 2) {
+        map.erase(i);
+    }
+
+    ASSERT_EQ(map.size(), 5000);
+    ASSERT_EQ(map.at(4999), 4999);
+    ASSERT_EQ(list.back(), 9999);
+    ASSERT_EQ(vector[1234], 1234);
+}
+
+TEST(MemoryResourceTest, AllocatesOverAlignedMemory) {
+    in_place_memory memory;
+    memory_resource resource{ memory };
+
+    void* ptr1 = resource.allocate(24, 64);
+    void* ptr2 = resource.allocate(100, 256);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr1) % 64, 0);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr2) % 256, 0);
+
+    resource.deallocate(ptr1, 24, 64);
+    resource.deallocate(ptr2, 100, 256);
+}
+
+TEST(MemoryResourceTest, ThrowsForUnsupportedAlignment) {
+    in_place_memory memory;
+    memory_resource resource{ memory };
+
+    ASSERT_THROW((void)resource.allocate(8, 1024), std::bad_alloc);
+}
+}
@@ -1,5 +1,6 @@
 #include "src/memory_slab.h"
 #include <gtest/gtest.h>
+#include <vector>
 
 namespace allocator {
 
@@ -173,4 +174,174 @@ TEST(MemorySlabTest, ReturnsNextFreeElement) {
     ASSERT_EQ(slab.get_first_free_element(), 2);
 }
 
+TEST(MemorySlabTest, TracksAll64Elements) {
+    memory_slab<1024> slab;
+    slab.reset_elements(8);
+
+    ASSERT_EQ(slab.max_elements(), 64);
+
+    slab.set_element(40);
+
+    ASSERT_TRUE(slab.has_element(40));
+    ASSERT_FALSE(slab.has_element(8));
+    ASSERT_EQ(slab.get_first_free_element(), 0);
+
+    for (std::size_t i = 0; i < slab.max_elements(); ++i) {
+        slab.set_element(i);
+    }
+
+    ASSERT_TRUE(slab.is_full());
+
+    slab.clear_element(63);
+
+    ASSERT_FALSE(slab.is_full());
+    ASSERT_EQ(slab.get_first_free_element(), 63);
+}
+
+TEST(MemorySlabTest, MultiWordBitmapResetsToEmpty) {
+    memory_slab<4096, 8> slab;
+    slab.reset_elements(8);
+
+    ASSERT_EQ(slab.max_elements(), (4096 - memory_slab<4096, 8>::data_block_offset) / 8);
+    ASSERT_TRUE(slab.is_empty());
+    ASSERT_FALSE(slab.is_full());
+    ASSERT_EQ(slab.get_first_free_element(), 0);
+}
+
+TEST(MemorySlabTest, MultiWordBitmapSetsElementsInHigherWords) {
+    memory_slab<4096, 8> slab;
+    slab.reset_elements(8);
+
+    slab.set_element(200);
+
+    ASSERT_TRUE(slab.has_element(200));
+    ASSERT_FALSE(slab.has_element(8));
+    ASSERT_FALSE(slab.has_element(199));
+    ASSERT_FALSE(slab.is_empty());
+    ASSERT_EQ(slab.get_first_free_element(), 0);
+
+    slab.clear_element(200);
+
+    ASSERT_TRUE(slab.is_empty());
+}
+
+TEST(MemorySlabTest, MultiWordBitmapFindsFreeElementInNextWord) {
+    memory_slab<4096, 8> slab;
+    slab.reset_elements(8);
+
+    for (std::size_t i = 0; i < 130; ++i) {
+        slab.set_element(i);
+    }
+
+    ASSERT_EQ(slab.get_first_free_element(), 130);
+
+    slab.clear_element(70);
+
+    ASSERT_EQ(slab.get_first_free_element(), 70);
+}
+
+TEST(MemorySlabTest, MultiWordBitmapBecomesFull) {
+    memory_slab<4096, 8> slab;
+    slab.reset_elements(8);
+
+    for (std::size_t i = 0; i < slab.max_elements(); ++i) {
+        ASSERT_FALSE(slab.is_full());
+        slab.set_element(i);
+    }
+
+    ASSERT_TRUE(slab.is_full());
+
+    slab.clear_element(slab.max_elements() - 1);
+
+    ASSERT_FALSE(slab.is_full());
+    ASSERT_EQ(slab.get_first_free_element(), slab.max_elements() - 1);
+}
+
+TEST(MemorySlabTest, MultiWordBitmapIsCappedByNumberOfWords) {
+    memory_slab<4096, 2> slab;
+    slab.reset_elements(8);
+
+    ASSERT_EQ(slab.max_elements(), 128);
+}
+
+TEST(MemorySlabTest, CountsElements) {
+    memory_slab<1024> slab;
+    slab.reset_elements(16);
+
+    ASSERT_EQ(slab.count_elements(), 0);
+
+    slab.set_element(0);
+    slab.set_element(5);
+    slab.set_element(7);
+
+    ASSERT_EQ(slab.count_elements(), 3);
+
+    slab.clear_element(5);
+
+    ASSERT_EQ(slab.count_elements(), 2);
+}
+
+TEST(MemorySlabTest, MultiWordBitmapCountsElementsInAllWords) {
+    memory_slab<4096, 8> slab;
+    slab.reset_elements(8);
+
+    for (std::size_t i = 0; i < 200; i += 3) {
+        slab.set_element(i);
+    }
+
+    ASSERT_EQ(slab.count_elements(), 67);
+}
+
+TEST(MemorySlabTest, CompactHeadersLinkSlabsByDistance) {
+    std::vector<memory_slab<256, 1, true>> slabs(4);
+
+    slabs[0].header.neighbors.next = &slabs[3];
+    slabs[3].header.neighbors.previous = &slabs[0];
+    slabs[1].header.free_list.next = nullptr;
+
+    ASSERT_EQ(slabs[0].header.neighbors.next.distance, 3);
+    ASSERT_EQ(slabs[3].header.neighbors.previous.distance, -3);
+    ASSERT_EQ(slabs[0].header.neighbors.next, &slabs[3]);
+    ASSERT_EQ(slabs[3].header.neighbors.previous, &slabs[0]);
+    ASSERT_EQ(slabs[1].header.free_list.next, nullptr);
+
+    slabs[1].header.neighbors.next = slabs[0].header.neighbors.next;
+
+    ASSERT_EQ(slabs[1].header.neighbors.next.distance, 2);
+    ASSERT_EQ(slabs[1].header.neighbors.next, &slabs[3]);
+}
+
+TEST(MemorySlabTest, CompactHeadersUse32BitWords) {
+    memory_slab<4096, 1, true> slab;
+    slab.reset_elements(16);
+
+    ASSERT_EQ(slab.max_elements(), 32);
+
+    for (std::size_t i = 0; i < 32; ++i) {
+        slab.set_element(slab.get_first_free_element());
+    }
+
+    ASSERT_TRUE(slab.is_full());
+    ASSERT_EQ(slab.count_elements(), 32);
+}
+
+TEST(MemorySlabTest, CompactHeadersSupportMultiWordBitmaps) {
+    memory_slab<4096, 4, true> slab;
+    slab.reset_elements(32);
+
+    ASSERT_EQ(slab.max_elements(), (4096 - 64) / 32);
+
+    for (std::size_t i = 0; i < slab.max_elements(); ++i) {
+        slab.set_element(slab.get_first_free_element());
+    }
+
+    ASSERT_TRUE(slab.is_full());
+    ASSERT_EQ(slab.get_free_elements_mask(3), 0);
+
+    slab.clear_element(100);
+
+    ASSERT_FALSE(slab.is_full());
+    ASSERT_EQ(slab.get_first_free_element(), 100);
+}
+
 }
\ No newline at end of file
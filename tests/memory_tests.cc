@@ -1,5 +1,7 @@
 #include "src/memory.h"
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <vector>
 
 namespace allocator {
 
@@ -59,4 +61,175 @@ TEST(MemoryTests, AllocatesBiggerObjectAfterFreeingSmaller) {
     ASSERT_EQ(*value2, 43);
 }
 
+TEST(MemoryTests, AllocatesOverAlignedObjects) {
+    struct alignas(64) counter {
+        std::size_t value;
+    };
+
+    in_place_memory memory;
+    auto* const value1 = memory.allocate<counter>(1);
+    auto* const value2 = memory.allocate<counter>(2);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(value1) % 64, 0);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(value2) % 64, 0);
+    ASSERT_EQ(value1->value, 1);
+    ASSERT_EQ(value2->value, 2);
+
+    memory.deallocate(value1);
+    memory.deallocate(value2);
+}
+
+TEST(MemoryTests, AllocatesPageAlignedBuffers) {
+    mmap_memory<8192> memory;
+    void* const buffer = memory.allocate(3000, 4096);
+
+    ASSERT_NE(buffer, nullptr);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(buffer) % 4096, 0);
+
+    memory.deallocate(buffer);
+}
+TEST(MemoryTests, ReallocatesGrowingBuffer) {
+    mmap_memory<1024> memory;
+    auto* buffer = static_cast<std::uint32_t*>(memory.allocate(sizeof(std::uint32_t)));
+    std::size_t size = 1;
+
+    buffer[0] = 0;
+
+    while (size < 64 * 1024) {
+        buffer = static_cast<std::uint32_t*>(memory.reallocate(buffer, 2 * size * sizeof(std::uint32_t)));
+
+        for (std::size_t i = size; i < 2 * size; ++i) {
+            buffer[i] = static_cast<std::uint32_t>(i);
+        }
+
+        size *= 2;
+    }
+
+    for (std::size_t i = 0; i < size; ++i) {
+        ASSERT_EQ(buffer[i], i);
+    }
+
+    memory.deallocate(buffer);
+}
+
+TEST(MemoryTests, CollectsStatistics) {
+    memory<mmap_block_allocator<>, 1024, 1, { .collect_statistics = true }> memory;
+    auto* const data = memory.allocate(100);
+
+    ASSERT_GT(memory.statistics().reserved_bytes, 0);
+    ASSERT_EQ(memory.statistics().live_bytes, 128);
+    ASSERT_EQ(memory.statistics().failed_allocations, 1);
+
+    memory.deallocate(data);
+
+    ASSERT_EQ(memory.statistics().live_bytes, 0);
+}
+
+TEST(MemoryTests, AllocatesWithOutOfBandHeaders) {
+    memory<mmap_block_allocator<>, 256, 1, { .segment_size = 64 * 1024, .out_of_band_headers = true }> memory;
+    std::vector<void*> ptrs;
+
+    for (std::size_t i = 0; i < 10000; ++i) {
+        ptrs.push_back(memory.allocate(16 + i % 1000));
+        ASSERT_NE(ptrs.back(), nullptr);
+    }
+
+    std::size_t segments = 0;
+    std::size_t elements = 0;
+
+    memory.walk_heap([&](const heap_slab_info& info) {
+        segments = std::max(segments, info.segment_index + 1);
+        elements += info.state == slab_state::free_run ? 0 : info.state == slab_state::small_objects ? info.elements : 1;
+    });
+
+    ASSERT_GT(segments, 1);
+    ASSERT_GE(elements, ptrs.size());
+
+    for (auto* ptr : ptrs) {
+        memory.deallocate(ptr);
+    }
+
+    ASSERT_EQ(memory.allocate(64 * 1024), nullptr);
+}
+
+TEST(MemoryTests, CompactHeadersRejectAllocationsAbove4GiB) {
+    memory<mmap_block_allocator<>, 1024, 1, { .collect_statistics = true, .compact_headers = true }> memory;
+
+    ASSERT_EQ(memory.allocate(std::size_t{ 5 } << 30), nullptr);
+    ASSERT_EQ(memory.allocate(std::size_t{ 5 } << 30, 256), nullptr);
+    ASSERT_EQ(memory.statistics().reserved_bytes, 0);
+
+    auto* const data = memory.allocate(100);
+
+    ASSERT_NE(data, nullptr);
+    memory.deallocate(data);
+}
+
+TEST(MemoryTests, ServesLargeAllocationsFromDirectMappings) {
+    using memory_t = memory<mmap_block_allocator<>, 1024, 1, { .direct_mapping_threshold = 64 * 1024 }>;
+
+    memory_t memory;
+    auto* const small = memory.allocate(100);
+    auto* const largest_in_slabs = memory.allocate(64 * 1024 - memory_t::slab_t::data_block_offset);
+    auto* const smallest_mapped = memory.allocate(64 * 1024 - memory_t::slab_t::data_block_offset + 1);
+    auto* const huge = memory.allocate(1024 * 1024);
+
+    ASSERT_LT(memory_t::slab_t::from_pointer(largest_in_slabs)->header.metadata.element_size, 64 * 1024);
+    ASSERT_GE(memory_t::slab_t::from_pointer(smallest_mapped)->header.metadata.element_size, 64 * 1024);
+    ASSERT_GE(memory_t::slab_t::from_pointer(huge)->header.metadata.element_size, 1024 * 1024);
+
+    std::size_t mapped_bytes = 0;
+    std::size_t segments = 0;
+
+    memory.walk_heap([&](const heap_slab_info& info) {
+        segments = std::max(segments, info.segment_index + 1);
+        mapped_bytes += info.segment_index > 0 ? info.size : 0;
+    });
+
+    ASSERT_EQ(segments, 3);
+    ASSERT_GE(mapped_bytes, 64 * 1024 + 1024 * 1024);
+
+    memory.deallocate(huge);
+    memory.deallocate(smallest_mapped);
+    memory.deallocate(largest_in_slabs);
+    memory.deallocate(small);
+
+    ASSERT_EQ(memory.allocate(1000 * 1024), huge);
+}
+
+TEST(MemoryTests, AllocatesAlignedDirectMappings) {
+    memory<mmap_block_allocator<>, 1024, 1, { .direct_mapping_threshold = 64 * 1024 }> memory;
+    void* const buffer = memory.allocate(256 * 1024, 512);
+
+    ASSERT_NE(buffer, nullptr);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(buffer) % 512, 0);
+
+    memory.deallocate(buffer);
+}
+
+TEST(MemoryTests, ReallocatesAcrossDirectMappingThreshold) {
+    memory<mmap_block_allocator<>, 1024, 1, { .direct_mapping_threshold = 16 * 1024 }> memory;
+    auto* buffer = static_cast<std::uint32_t*>(memory.allocate(sizeof(std::uint32_t)));
+    std::size_t size = 1;
+
+    buffer[0] = 0;
+
+    while (size < 256 * 1024) {
+        buffer = static_cast<std::uint32_t*>(memory.reallocate(buffer, 2 * size * sizeof(std::uint32_t)));
+
+        for (std::size_t i = size; i < 2 * size; ++i) {
+            buffer[i] = static_cast<std::uint32_t>(i);
+        }
+
+        size *= 2;
+    }
+
+    buffer = static_cast<std::uint32_t*>(memory.reallocate(buffer, 100 * sizeof(std::uint32_t)));
+
+    for (std::size_t i = 0; i < 100; ++i) {
+        ASSERT_EQ(buffer[i], i);
+    }
+
+    memory.deallocate(buffer);
+}
 }
\ No newline at end of file
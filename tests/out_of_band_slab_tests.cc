@@ -0,0 +1,75 @@
+#include "src/out_of_band_slab.h"
+#include "src/utils.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace allocator {
+
+namespace {
+
+using slab_t = out_of_band_slab<256, 16 * 1024>;
+
+struct alignas(16 * 1024) segment_memory {
+    std::byte data[16 * 1024];
+};
+
+}
+
+TEST(OutOfBandSlabTest, FitsHeaderTableIntoFirstSlabs) {
+    ASSERT_EQ(slab_t::header_table_slabs, 12);
+    ASSERT_EQ(slab_t::slab_count, 52);
+    ASSERT_LE(slab_t::slab_count * sizeof(slab_t), slab_t::header_table_slabs * 256);
+    ASSERT_EQ(slab_t::data_block_offset, 0);
+    ASSERT_EQ(slab_t::data_block_size, 256);
+}
+
+TEST(OutOfBandSlabTest, LaundersHeaderTable) {
+    std::vector<segment_memory> segments(1);
+    auto* const slab = launder_header_table<slab_t>(segments.data());
+
+    ASSERT_EQ(reinterpret_cast<std::byte*>(slab), segments[0].data);
+    ASSERT_EQ(slab->data_block(), segments[0].data + 12 * 256);
+    ASSERT_EQ(slab->header.metadata.element_size, 52 * 256);
+    ASSERT_TRUE(slab->is_empty());
+}
+
+TEST(OutOfBandSlabTest, FindsHeaderOfPointer) {
+    std::vector<segment_memory> segments(1);
+    auto* const slab = launder_header_table<slab_t>(segments.data());
+
+    ASSERT_EQ(slab_t::from_pointer(segments[0].data + 12 * 256), slab);
+    ASSERT_EQ(slab_t::from_pointer(segments[0].data + 12 * 256 + 255), slab);
+    ASSERT_EQ(slab_t::from_pointer(segments[0].data + 13 * 256), slab + 1);
+    ASSERT_EQ(slab_t::from_pointer(segments[0].data + 16 * 1024 - 1), slab + 51);
+    ASSERT_EQ(slab->slab_at_offset(3 * 256), slab + 3);
+    ASSERT_EQ((slab + 3)->data_block(), segments[0].data + 15 * 256);
+}
+
+TEST(OutOfBandSlabTest, UsesWholeSlabForElements) {
+    std::vector<segment_memory> segments(1);
+    auto* const slab = launder_header_table<slab_t>(segments.data());
+
+    slab->reset_elements(16);
+
+    ASSERT_EQ(slab->max_elements(), 16);
+    ASSERT_EQ(slab->get_element(15), slab->data_block() + 240);
+}
+
+TEST(OutOfBandSlabTest, CompactHeadersLinkSlabsOfDifferentSegments) {
+    using compact_slab_t = out_of_band_slab<64, 16 * 1024, 1, true>;
+
+    std::vector<segment_memory> segments(2);
+    auto* const first = launder_header_table<compact_slab_t>(&segments[0]);
+    auto* const second = launder_header_table<compact_slab_t>(&segments[1]);
+
+    ASSERT_EQ(compact_slab_t::from_header_address(&first[5].header.free_list.next), &first[5]);
+
+    first[5].header.free_list.next = &second[2];
+    second[2].header.free_list.previous = &first[5];
+
+    ASSERT_EQ(first[5].header.free_list.next, &second[2]);
+    ASSERT_EQ(second[2].header.free_list.previous, &first[5]);
+    ASSERT_EQ(first[5].header.free_list.next.distance, 256 - 5 + 2);
+}
+
+}
\ No newline at end of file
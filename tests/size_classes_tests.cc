@@ -0,0 +1,112 @@
+#include "src/size_classes.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace allocator {
+
+TEST(SizeClassesTest, RoundsUpToPowersOfTwoByDefault) {
+    using classes = size_classes<960>;
+
+    ASSERT_EQ(classes::class_size(1), 1);
+    ASSERT_EQ(classes::class_size(3), 4);
+    ASSERT_EQ(classes::class_size(16), 16);
+    ASSERT_EQ(classes::class_size(17), 32);
+    ASSERT_EQ(classes::class_size(33), 64);
+    ASSERT_EQ(classes::class_size(65), 128);
+    ASSERT_EQ(classes::class_size(513), 1024);
+}
+
+TEST(SizeClassesTest, DefaultClassIndexIsPowerOfTwoExponent) {
+    using classes = size_classes<960>;
+
+    for (std::size_t size = 1; size < 960; ++size) {
+        ASSERT_EQ(classes::class_index(size), std::bit_width(size - 1));
+    }
+
+    ASSERT_EQ(classes::count(), 11);
+}
+
+TEST(SizeClassesTest, DividesDoublingsIntoFourClasses) {
+    using classes = size_classes<960, 4>;
+
+    std::vector<std::size_t> class_sizes;
+    for (std::size_t size = 1; size < 960; size = classes::class_size(size) + 1) {
+        class_sizes.push_back(classes::class_size(size));
+    }
+
+    ASSERT_EQ(class_sizes, (std::vector<std::size_t>{
+        1, 2, 4, 8, 16, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384, 448, 512, 640, 768, 896, 1024 }));
+}
+
+TEST(SizeClassesTest, KeepsClassesAlignedToMinSpacing) {
+    using classes = size_classes<4096, 16>;
+
+    for (std::size_t size = classes::min_class_spacing + 1; size < 4096; ++size) {
+        ASSERT_EQ(classes::class_size(size) % classes::min_class_spacing, 0);
+        ASSERT_GE(classes::class_size(size), size);
+    }
+}
+
+TEST(SizeClassesTest, AssignsDistinctIndicesToDistinctClasses) {
+    using classes = size_classes<4096, 4>;
+
+    std::size_t previous_index = classes::class_index(1);
+    for (std::size_t size = 2; size < 4096; ++size) {
+        const auto index = classes::class_index(size);
+
+        if (classes::class_size(size) == classes::class_size(size - 1)) {
+            ASSERT_EQ(index, previous_index);
+        }
+        else {
+            ASSERT_GT(index, previous_index);
+        }
+
+        ASSERT_LT(index, classes::count());
+        previous_index = index;
+    }
+}
+
+template <typename _classes_t>
+void assert_dense_indices(const std::size_t max_size) {
+    std::size_t classes = 1;
+
+    for (std::size_t size = 2; size < max_size; ++size) {
+        if (_classes_t::class_size(size) != _classes_t::class_size(size - 1)) {
+            ASSERT_EQ(_classes_t::class_index(size), classes);
+            ++classes;
+        }
+    }
+
+    ASSERT_EQ(_classes_t::count(), classes);
+}
+
+TEST(SizeClassesTest, AssignsDenseIndices) {
+    assert_dense_indices<size_classes<960, 4>>(960);
+    assert_dense_indices<size_classes<960, 16>>(960);
+    assert_dense_indices<size_classes<4032, 8>>(4032);
+    assert_dense_indices<size_classes<4032, 16>>(4032);
+
+    ASSERT_EQ((size_classes<960, 16>::count()), 50);
+    ASSERT_EQ((size_classes<4032, 16>::count()), 84);
+}
+
+TEST(SizeClassesTest, ComputesElementIndexWithoutDivision) {
+    using classes = size_classes<4096 - 64, 4>;
+
+    for (std::size_t size = 1; size < 4096 - 64; size = classes::class_size(size) + 1) {
+        const auto element_size = classes::class_size(size);
+
+        for (std::size_t offset = 0; offset < 4096 - 64; ++offset) {
+            ASSERT_EQ(classes::element_index(offset, element_size), offset / element_size);
+        }
+    }
+}
+
+TEST(SizeClassesTest, ComputesElementIndexForLargeElements) {
+    using classes = size_classes<960, 4>;
+
+    ASSERT_EQ(classes::element_index(0, 960), 0);
+    ASSERT_EQ(classes::element_index(0, 1024 * 1024), 0);
+}
+
+}
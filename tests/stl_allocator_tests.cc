@@ -0,0 +1,116 @@
+#include "src/memory.h"
+#include "src/stl_allocator.h"
+#include <gtest/gtest.h>
+#include <deque>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace allocator {
+
+using test_memory = mmap_memory<1024>;
+
+template <typename T>
+using test_allocator = stl_allocator<T, test_memory>;
+
+TEST(StlAllocatorTest, AllocatesFromBoundMemory) {
+    in_place_memory memory;
+    stl_allocator<int, in_place_memory<>> allocator{ memory };
+
+    int* ptr1 = allocator.allocate(1);
+    allocator.deallocate(ptr1, 1);
+    int* ptr2 = allocator.allocate(1);
+
+    ASSERT_EQ(ptr1, ptr2);
+}
+
+TEST(StlAllocatorTest, RebindsToOtherTypes) {
+    test_memory memory;
+    test_allocator<int> int_allocator{ memory };
+    test_allocator<double> double_allocator{ int_allocator };
+
+    using rebound_allocator = std::allocator_traits<test_allocator<int>>::rebind_alloc<double>;
+
+    ASSERT_TRUE((std::is_same_v<rebound_allocator, test_allocator<double>>));
+    ASSERT_EQ(&double_allocator.memory(), &memory);
+    ASSERT_TRUE(int_allocator == double_allocator);
+}
+
+TEST(StlAllocatorTest, ComparesEqualForSameMemory) {
+    test_memory memory1;
+    test_memory memory2;
+
+    ASSERT_TRUE(test_allocator<int>{ memory1 } == test_allocator<int>{ memory1 });
+    ASSERT_FALSE(test_allocator<int>{ memory1 } == test_allocator<int>{ memory2 });
+}
+
+TEST(StlAllocatorTest, ThrowsWhenExhausted) {
+    free_memory_manager<256> manager;
+    memory_slab<256> slabs[2];
+    launder_slab(slabs, 2);
+    manager.add_new_memory_segment(slabs);
+    stl_allocator<int, free_memory_manager<256>> allocator{ manager };
+
+    ASSERT_THROW(allocator.allocate(1024), std::bad_alloc);
+}
+
+TEST(StlAllocatorTest, BacksNodeContainers) {
+    test_memory memory;
+
+    std::map<int, int, std::less<int>, test_allocator<std::pair<const int, int>>> map{ test_allocator<int>{ memory } };
+    std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, test_allocator<std::pair<const int, int>>> unordered_map{ test_allocator<int>{ memory } };
+    std::list<int, test_allocator<int>> list{ test_allocator<int>{ memory } };
+    std::deque<int, test_allocator<int>> deque{ test_allocator<int>{ memory } };
+
+    for (int i = 0; i < 10000; ++i) {
+        map.emplace(i, i);
+        unordered_map.emplace(i, i);
+        list.push_back(i);
+        deque.push_back(i);
+    }
+
+    for (int i = 0; i < 10000; i += 2) {
+        map.erase(i);
+        unordered_map.erase(i);
+        list.pop_front();
+        deque.pop_front();
+    }
+
+    ASSERT_EQ(map.size(), 5000);
+    ASSERT_EQ(unordered_map.size(), 5000);
+    ASSERT_EQ(map.at(4999), 4999);
+    ASSERT_EQ(unordered_map.at(4999), 4999);
+    ASSERT_EQ(list.front(), 5000);
+    ASSERT_EQ(deque.front(), 5000);
+}
+
+TEST(StlAllocatorTest, PropagatesOnMoveAssignment) {
+    test_memory memory1;
+    test_memory memory2;
+
+    std::vector<int, test_allocator<int>> vector1{ test_allocator<int>{ memory1 } };
+    std::vector<int, test_allocator<int>> vector2{ test_allocator<int>{ memory2 } };
+    vector1.push_back(42);
+    vector2 = std::move(vector1);
+
+    ASSERT_EQ(&vector2.get_allocator().memory(), &memory1);
+    ASSERT_EQ(vector2.front(), 42);
+}
+
+TEST(StlAllocatorTest, AllocatesOverAlignedTypes) {
+    struct alignas(64) counter {
+        std::size_t value;
+    };
+
+    test_memory memory;
+    std::vector<counter, test_allocator<counter>> counters{ test_allocator<counter>{ memory } };
+
+    for (std::size_t i = 0; i < 100; ++i) {
+        counters.push_back({ i });
+    }
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(counters.data()) % 64, 0);
+    ASSERT_EQ(counters[99].value, 99);
+}
+}
@@ -0,0 +1,244 @@
+#include "src/segment_pool.h"
+#include "src/thread_cache.h"
+#include <gtest/gtest.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace allocator {
+
+using test_segment_pool = segment_pool<in_place_block_allocator<4 * 16 * 1024, 16 * 1024>, 256, 16 * 1024>;
+using test_thread_cache = thread_cache<test_segment_pool>;
+
+const std::size_t half_segment_allocation = 8 * 1024;
+
+class ThreadCacheTest : public ::testing::Test {
+protected:
+    std::size_t segment_count(const test_thread_cache& cache) {
+        return cache._segment_count;
+    }
+
+    bool has_remote_frees(const test_thread_cache& cache) {
+        return cache._remote_frees.load() != nullptr;
+    }
+};
+
+TEST_F(ThreadCacheTest, AllocatesFromAcquiredSegment) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_thread_cache cache{ *pool };
+
+    void* ptr = cache.allocate(8);
+
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_EQ(test_segment_pool::segment_t::from_pointer(ptr)->header.owner, &cache);
+    ASSERT_EQ(segment_count(cache), 1);
+}
+
+TEST_F(ThreadCacheTest, ReusesAcquiredSegment) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_thread_cache cache{ *pool };
+
+    void* ptr1 = cache.allocate(8);
+    void* ptr2 = cache.allocate(64);
+    void* ptr3 = cache.allocate(1024);
+
+    ASSERT_EQ(test_segment_pool::segment_t::from_pointer(ptr1), test_segment_pool::segment_t::from_pointer(ptr2));
+    ASSERT_EQ(test_segment_pool::segment_t::from_pointer(ptr1), test_segment_pool::segment_t::from_pointer(ptr3));
+    ASSERT_EQ(segment_count(cache), 1);
+}
+
+TEST_F(ThreadCacheTest, RetainsLastEmptySegment) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_thread_cache cache{ *pool };
+
+    void* ptr = cache.allocate(8);
+    cache.deallocate(ptr);
+
+    ASSERT_EQ(segment_count(cache), 1);
+}
+
+TEST_F(ThreadCacheTest, ReturnsEmptySegmentsToPool) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_thread_cache cache1{ *pool };
+    test_thread_cache cache2{ *pool };
+
+    std::vector<void*> ptrs;
+    for (std::size_t i = 0; i < 4; ++i) {
+        ptrs.push_back(cache1.allocate(half_segment_allocation));
+        ASSERT_NE(ptrs.back(), nullptr);
+    }
+
+    ASSERT_EQ(segment_count(cache1), 4);
+
+    for (auto* ptr : ptrs) {
+        cache1.deallocate(ptr);
+    }
+
+    ASSERT_EQ(segment_count(cache1), 1);
+
+    for (std::size_t i = 0; i < 3; ++i) {
+        void* ptr = cache2.allocate(half_segment_allocation);
+        ASSERT_NE(ptr, nullptr);
+        ASSERT_EQ(test_segment_pool::segment_t::from_pointer(ptr)->header.owner, &cache2);
+    }
+
+    ASSERT_EQ(segment_count(cache2), 3);
+}
+
+TEST_F(ThreadCacheTest, ThreadsAllocateFromTheirOwnSegments) {
+    auto pool = std::make_unique<test_segment_pool>();
+    std::vector<std::thread> threads;
+
+    for (std::size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, t] {
+            test_thread_cache cache{ *pool };
+
+            for (std::size_t round = 0; round < 100; ++round) {
+                std::vector<std::size_t*> ptrs;
+
+                for (std::size_t i = 0; i < 100; ++i) {
+                    auto* ptr = static_cast<std::size_t*>(cache.allocate(sizeof(std::size_t) * (1 + i % 4)));
+                    ASSERT_NE(ptr, nullptr);
+                    ASSERT_EQ(test_segment_pool::segment_t::from_pointer(ptr)->header.owner, &cache);
+                    *ptr = t * 1000 + i;
+                    ptrs.push_back(ptr);
+                }
+
+                for (std::size_t i = 0; i < ptrs.size(); ++i) {
+                    ASSERT_EQ(*ptrs[i], t * 1000 + i);
+                    cache.deallocate(ptrs[i]);
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+TEST_F(ThreadCacheTest, DefersRemoteFreesToOwner) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_thread_cache owner{ *pool };
+    test_thread_cache foreigner{ *pool };
+
+    void* ptr1 = owner.allocate(8);
+    void* ptr2 = owner.allocate(8);
+    foreigner.deallocate(ptr1);
+
+    ASSERT_TRUE(has_remote_frees(owner));
+    ASSERT_EQ(segment_count(foreigner), 0);
+
+    void* ptr3 = owner.allocate(8);
+
+    ASSERT_FALSE(has_remote_frees(owner));
+    ASSERT_EQ(ptr3, ptr1);
+    ASSERT_NE(ptr2, ptr1);
+
+    // The drain only released the remotely freed element, so the other one is reused once the owner frees it.
+    owner.deallocate(ptr2);
+
+    ASSERT_EQ(owner.allocate(8), ptr2);
+}
+
+TEST_F(ThreadCacheTest, DrainsRemoteFreesInBatches) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_thread_cache owner{ *pool };
+    test_thread_cache foreigner{ *pool };
+
+    std::vector<void*> ptrs;
+    for (std::size_t i = 0; i < 3; ++i) {
+        ptrs.push_back(owner.allocate(half_segment_allocation));
+    }
+
+    ASSERT_EQ(segment_count(owner), 3);
+
+    for (auto* ptr : ptrs) {
+        foreigner.deallocate(ptr);
+    }
+
+    ASSERT_EQ(segment_count(owner), 3);
+
+    void* ptr = owner.allocate(8);
+
+    ASSERT_NE(ptr, nullptr);
+    ASSERT_FALSE(has_remote_frees(owner));
+    ASSERT_EQ(segment_count(owner), 1);
+}
+
+TEST_F(ThreadCacheTest, ReleasesMemoryAllocatedOnOtherThreads) {
+    auto pool = std::make_unique<test_segment_pool>();
+    std::vector<std::unique_ptr<test_thread_cache>> caches;
+    std::vector<std::thread> threads;
+    std::array<std::atomic<std::size_t*>, 64> slots{};
+
+    for (std::size_t t = 0; t < 4; ++t) {
+        caches.push_back(std::make_unique<test_thread_cache>(*pool));
+    }
+
+    for (std::size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&cache = *caches[t], &slots, t] {
+            for (std::size_t i = 0; i < 10000; ++i) {
+                auto* ptr = static_cast<std::size_t*>(cache.allocate(sizeof(std::size_t) * (1 + i % 4)));
+                ASSERT_NE(ptr, nullptr);
+                *ptr = i;
+
+                auto* previous = slots[(t * 7 + i) % slots.size()].exchange(ptr);
+                if (previous != nullptr) {
+                    cache.deallocate(previous);
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (auto& slot : slots) {
+        auto* previous = slot.exchange(nullptr);
+        if (previous != nullptr) {
+            caches[0]->deallocate(previous);
+        }
+    }
+
+    for (auto& cache : caches) {
+        cache->allocate(8);
+        ASSERT_FALSE(has_remote_frees(*cache));
+    }
+}
+
+TEST_F(ThreadCacheTest, AllocatesAlignedMemory) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_thread_cache cache{ *pool };
+
+    void* ptr1 = cache.allocate(8, 64);
+    void* ptr2 = cache.allocate(100, 128);
+
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr1) % 64, 0);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(ptr2) % 128, 0);
+
+    cache.deallocate(ptr1);
+    cache.deallocate(ptr2);
+}
+
+TEST_F(ThreadCacheTest, RejectsAllocationsLargerThanSegment) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_thread_cache cache{ *pool };
+
+    for (std::size_t i = 0; i < 100; ++i) {
+        ASSERT_EQ(cache.allocate(16 * 1024), nullptr);
+        ASSERT_EQ(cache.allocate(16 * 1024, 256), nullptr);
+    }
+
+    ASSERT_EQ(segment_count(cache), 0);
+    ASSERT_NE(cache.allocate(8), nullptr);
+
+    for (std::size_t i = 0; i < 100; ++i)
+        ASSERT_EQ(cache.allocate(16 * 1024), nullptr);
+
+    ASSERT_EQ(segment_count(cache), 1);
+}
+}
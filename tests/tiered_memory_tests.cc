@@ -0,0 +1,139 @@
+#include "src/segment_pool.h"
+#include "src/tiered_memory.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace allocator {
+
+namespace {
+
+using test_segment_pool = segment_pool<in_place_block_allocator<4 * 16 * 1024, 16 * 1024>, 256, 16 * 1024>;
+using test_tiered_memory = tiered_memory<test_segment_pool, 256, 1024, 4096>;
+
+// Takes three of the 4096-byte slabs of a 16 KiB segment (the first one holds the segment header).
+const std::size_t whole_segment_allocation = 8 * 1024;
+
+void* segment_owner(void* const data) {
+    return test_segment_pool::segment_t::from_pointer(data)->header.owner;
+}
+
+}
+
+TEST(TieredMemoryTest, RoutesSizesThroughConstexprTable) {
+    static_assert(test_tiered_memory::tier_index(0) == 0);
+    static_assert(test_tiered_memory::tier_index(1) == 0);
+    static_assert(test_tiered_memory::tier_index(64) == 0);
+    static_assert(test_tiered_memory::tier_index(65) == 1);
+    static_assert(test_tiered_memory::tier_index(256) == 1);
+    static_assert(test_tiered_memory::tier_index(257) == 2);
+    static_assert(test_tiered_memory::tier_index(1024 * 1024) == 2);
+    static_assert(test_tiered_memory::tier_index(~std::size_t{ 0 }) == 2);
+}
+
+TEST(TieredMemoryTest, AllocatesFromSegmentsOfItsTier) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_tiered_memory memory{ *pool };
+
+    void* small = memory.allocate(8);
+    void* mid = memory.allocate(200);
+    void* large = memory.allocate(2000);
+
+    ASSERT_NE(small, nullptr);
+    ASSERT_NE(mid, nullptr);
+    ASSERT_NE(large, nullptr);
+    ASSERT_NE(segment_owner(small), segment_owner(mid));
+    ASSERT_NE(segment_owner(mid), segment_owner(large));
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(small) % 256, 64);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(large) % 4096, 64);
+    ASSERT_EQ(memory.segment_count(0), 1);
+    ASSERT_EQ(memory.segment_count(1), 1);
+    ASSERT_EQ(memory.segment_count(2), 1);
+    ASSERT_EQ(segment_owner(memory.allocate(16)), segment_owner(small));
+}
+
+TEST(TieredMemoryTest, DeallocatesWithoutSize) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_tiered_memory memory{ *pool };
+
+    void* small = memory.allocate(8);
+    void* mid = memory.allocate(200);
+    void* large = memory.allocate(2000);
+
+    memory.deallocate(large);
+    memory.deallocate(small);
+    memory.deallocate(mid);
+    memory.deallocate(nullptr);
+
+    ASSERT_EQ(memory.allocate(8), small);
+    ASSERT_EQ(memory.allocate(200), mid);
+    ASSERT_EQ(memory.allocate(2000), large);
+}
+
+TEST(TieredMemoryTest, SharesSegmentsBetweenTiers) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_tiered_memory memory{ *pool };
+    std::vector<void*> small_objects;
+
+    for (std::size_t i = 0; i < 200; ++i) {
+        small_objects.push_back(memory.allocate(64));
+        ASSERT_NE(small_objects.back(), nullptr);
+    }
+
+    ASSERT_EQ(memory.segment_count(0), 2);
+
+    for (auto* const data : small_objects) {
+        memory.deallocate(data);
+    }
+
+    ASSERT_EQ(memory.segment_count(0), 1);
+
+    for (std::size_t i = 0; i < 3; ++i) {
+        ASSERT_NE(memory.allocate(whole_segment_allocation), nullptr);
+    }
+
+    ASSERT_EQ(memory.segment_count(2), 3);
+}
+
+TEST(TieredMemoryTest, ReleasesEmptySegmentsOnDestruction) {
+    auto pool = std::make_unique<test_segment_pool>();
+
+    {
+        test_tiered_memory memory{ *pool };
+
+        memory.deallocate(memory.allocate(8));
+        memory.deallocate(memory.allocate(200));
+        memory.deallocate(memory.allocate(2000));
+    }
+
+    test_tiered_memory memory{ *pool };
+
+    for (std::size_t i = 0; i < 4; ++i) {
+        ASSERT_NE(memory.allocate(whole_segment_allocation), nullptr);
+    }
+}
+
+TEST(TieredMemoryTest, AllocatesAlignedMemory) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_tiered_memory memory{ *pool };
+
+    void* small = memory.allocate(8);
+    void* aligned = memory.allocate(8, 512);
+
+    ASSERT_NE(aligned, nullptr);
+    ASSERT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % 512, 0);
+    ASSERT_NE(segment_owner(aligned), segment_owner(small));
+    ASSERT_EQ(memory.segment_count(1), 1);
+    ASSERT_EQ(memory.allocate(8, 8192), nullptr);
+}
+
+TEST(TieredMemoryTest, RejectsAllocationsLargerThanSegment) {
+    auto pool = std::make_unique<test_segment_pool>();
+    test_tiered_memory memory{ *pool };
+
+    ASSERT_EQ(memory.allocate(16 * 1024), nullptr);
+    ASSERT_EQ(memory.segment_count(2), 0);
+}
+
+}
@@ -0,0 +1,189 @@
+#include "src/free_memory_manager.h"
+#include "src/heap_walker.h"
+#include "src/memory.h"
+#include "src/typed_pool.h"
+#include "src/utils.h"
+#include <gtest/gtest.h>
+#include <array>
+#include <vector>
+
+namespace allocator {
+
+namespace {
+
+struct point final {
+    double x;
+    double y;
+};
+
+struct counted final {
+    explicit counted(int& instances) : instances{ instances } {
+        ++instances;
+    }
+
+    ~counted() {
+        --instances;
+    }
+
+    int& instances;
+};
+
+using test_manager = free_memory_manager<256>;
+using point_pool = typed_pool<point, test_manager>;
+
+}
+
+TEST(TypedPoolTest, ResolvesSlabLayoutAtCompileTime) {
+    static_assert(point_pool::element_size == 16);
+    static_assert(point_pool::slab_capacity == 12);
+    static_assert(point_pool::full_mask == 0xfff);
+
+    static_assert(typed_pool<char, free_memory_manager<4096>>::slab_capacity == 64);
+    static_assert(typed_pool<char, free_memory_manager<4096>>::full_mask == ~std::size_t{ 0 });
+    static_assert(typed_pool<char, free_memory_manager<256, { .compact_headers = true }>>::full_mask == 0xffffffff);
+}
+
+TEST(TypedPoolTest, AllocatesElementsFromSingleSlab) {
+    memory_slab<256> slabs[4];
+    launder_slab(slabs, 4);
+
+    test_manager manager;
+    manager.add_new_memory_segment(slabs);
+
+    point_pool pool{ manager };
+
+    auto* const first = pool.allocate();
+    auto* const second = pool.allocate();
+
+    ASSERT_EQ(first, slabs[0].data_block());
+    ASSERT_EQ(second, slabs[0].data_block() + 16);
+    ASSERT_EQ(slabs[0].header.metadata.element_size, 16);
+    ASSERT_EQ(slabs[0].header.metadata.mask, 0b11);
+    ASSERT_EQ(slabs[0].header.neighbors.next, &slabs[1]);
+
+    pool.deallocate(first);
+
+    ASSERT_EQ(slabs[0].header.metadata.mask, 0b10);
+    ASSERT_EQ(pool.allocate(), first);
+}
+
+TEST(TypedPoolTest, SharesSlabsWithManager) {
+    memory_slab<256> slabs[4];
+    launder_slab(slabs, 4);
+
+    test_manager manager;
+    manager.add_new_memory_segment(slabs);
+
+    point_pool pool{ manager };
+    std::vector<void*> points;
+
+    for (std::size_t i = 0; i < 13; ++i)
+        points.push_back(pool.allocate());
+
+    auto* const large = manager.allocate(200);
+
+    ASSERT_EQ(points[11], slabs[0].data_block() + 11 * 16);
+    ASSERT_EQ(points[12], slabs[1].data_block());
+    ASSERT_EQ(large, slabs[2].data_block());
+    ASSERT_EQ(manager.allocate(8), nullptr);
+
+    ASSERT_EQ(describe_slab(&slabs[0], 0).state, slab_state::small_objects);
+    ASSERT_EQ(describe_slab(&slabs[0], 0).elements, 12);
+    ASSERT_EQ(describe_slab(&slabs[1], 0).elements, 1);
+
+    for (auto* const data : points)
+        pool.deallocate(data);
+
+    manager.deallocate(large);
+
+    ASSERT_EQ(describe_slab(&slabs[0], 0).state, slab_state::large_allocation);
+    ASSERT_EQ(manager.allocate(8), slabs[1].data_block());
+}
+
+TEST(TypedPoolTest, KeepsOneSpareSlab) {
+    memory_slab<256> slabs[4];
+    launder_slab(slabs, 4);
+
+    test_manager manager;
+    manager.add_new_memory_segment(slabs);
+
+    {
+        point_pool pool{ manager };
+        std::vector<void*> points;
+
+        for (std::size_t i = 0; i < 24; ++i)
+            points.push_back(pool.allocate());
+
+        for (auto* const data : points)
+            pool.deallocate(data);
+
+        ASSERT_EQ(describe_slab(&slabs[0], 0).state, slab_state::large_allocation);
+        ASSERT_TRUE(slabs[1].is_empty());
+        ASSERT_EQ(slabs[1].header.neighbors.next, nullptr);
+    }
+
+    ASSERT_TRUE(slabs[0].is_empty());
+    ASSERT_EQ(slabs[0].header.neighbors.next, nullptr);
+}
+
+TEST(TypedPoolTest, ReturnsNullptrWhenOutOfMemory) {
+    memory_slab<256> slabs[2];
+    launder_slab(slabs, 2);
+
+    test_manager manager;
+    manager.add_new_memory_segment(slabs);
+
+    point_pool pool{ manager };
+
+    for (std::size_t i = 0; i < 12; ++i)
+        ASSERT_NE(pool.allocate(), nullptr);
+
+    ASSERT_EQ(pool.allocate(), nullptr);
+}
+
+TEST(TypedPoolTest, ConstructsAndDestroysObjects) {
+    mmap_memory<256> memory;
+    typed_pool<counted, mmap_memory<256>> pool{ memory };
+    std::array<counted*, 100> objects;
+    int instances = 0;
+
+    for (auto& object : objects)
+        object = pool.create(instances);
+
+    ASSERT_EQ(instances, 100);
+
+    for (auto* const object : objects)
+        pool.destroy(object);
+
+    ASSERT_EQ(instances, 0);
+}
+
+TEST(TypedPoolTest, WorksWithOutOfBandCompactHeaders) {
+    using oob_memory = memory<mmap_block_allocator<>, 64, 1, { .segment_size = 64 * 1024, .out_of_band_headers = true, .compact_headers = true }>;
+
+    oob_memory memory;
+    typed_pool<point, oob_memory> pool{ memory };
+    std::vector<void*> points;
+
+    static_assert(typed_pool<point, oob_memory>::slab_capacity == 4);
+
+    for (std::size_t i = 0; i < 1000; ++i)
+        points.push_back(pool.allocate());
+
+    auto* const large = memory.allocate(1000);
+
+    for (auto* const data : points)
+        pool.deallocate(data);
+
+    memory.deallocate(large);
+
+    std::size_t small_object_slabs = 0;
+
+    memory.walk_heap([&](const heap_slab_info& info) {
+        small_object_slabs += info.state == slab_state::small_objects;
+    });
+
+    ASSERT_EQ(small_object_slabs, 0);
+}
+
+}
@@ -0,0 +1,79 @@
+#include "src/heap_walker.h"
+#include "src/memory.h"
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs a simple workload and prints the fragmentation map and the size histogram of the resulting heap:
+// allocates the given number of objects (with sizes picked at random from the given list), then releases
+// the given percentage of them in random order. Helps picking the slab size for a known allocation pattern.
+//
+// usage: heap_dump <slab size> <allocation sizes, comma separated> <allocation count> [released percentage]
+
+template <std::size_t _slab_size>
+void dump_workload(const std::vector<std::size_t>& sizes, const std::size_t count, const std::size_t released_percentage) {
+    allocator::mmap_memory<_slab_size> memory;
+    std::mt19937 random{ 42 };
+    std::uniform_int_distribution<std::size_t> size_distribution{ 0, sizes.size() - 1 };
+    std::vector<void*> allocations;
+
+    for (std::size_t i = 0; i < count; ++i) {
+        allocations.push_back(memory.allocate(sizes[size_distribution(random)]));
+    }
+
+    std::shuffle(allocations.begin(), allocations.end(), random);
+
+    for (std::size_t i = 0; i < count * released_percentage / 100; ++i) {
+        memory.deallocate(allocations[i]);
+    }
+
+    allocator::print_fragmentation_map(std::cout, memory);
+    std::cout << '\n';
+    allocator::print_size_histogram(std::cout, memory);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "usage: " << argv[0] << " <slab size> <allocation sizes, comma separated> <allocation count> [released percentage]\n";
+        return 1;
+    }
+
+    const auto slab_size = std::strtoull(argv[1], nullptr, 10);
+    const auto count = std::strtoull(argv[3], nullptr, 10);
+    const auto released_percentage = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 0;
+
+    std::vector<std::size_t> sizes;
+    std::istringstream sizes_stream{ argv[2] };
+
+    for (std::string size; std::getline(sizes_stream, size, ',');) {
+        sizes.push_back(std::strtoull(size.c_str(), nullptr, 10));
+    }
+
+    if (sizes.empty()) {
+        std::cerr << "at least one allocation size is required\n";
+        return 1;
+    }
+
+    switch (slab_size) {
+    case 256:
+        dump_workload<256>(sizes, count, released_percentage);
+        break;
+    case 1024:
+        dump_workload<1024>(sizes, count, released_percentage);
+        break;
+    case 4096:
+        dump_workload<4096>(sizes, count, released_percentage);
+        break;
+    case 16384:
+        dump_workload<16384>(sizes, count, released_percentage);
+        break;
+    default:
+        std::cerr << "supported slab sizes: 256, 1024, 4096, 16384\n";
+        return 1;
+    }
+
+    return 0;
+}